@@ -1,4 +1,4 @@
-.PHONY: add-dependencies build build-debug clean run-api run-ballot-parser test
+.PHONY: add-dependencies bench build build-debug clean run-api run-ballot-parser test
 
 BUILD_DEBUG?=true
 
@@ -76,4 +76,7 @@ endif
 
 test: build
 	cmake --build build --target test
- 
\ No newline at end of file
+ 
+
+bench: build-release
+	cmake --build build --target bench
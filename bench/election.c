@@ -0,0 +1,425 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <electionguard/api/create_election.h>
+#include <electionguard/api/encrypt_ballot.h>
+#include <electionguard/api/load_ballots.h>
+#include <electionguard/api/record_ballots.h>
+#include <electionguard/api/tally_votes.h>
+#include <electionguard/max_values.h>
+
+/* Runs a whole election through the API and reports the wall time and
+ * throughput of each phase, as JSON, for sizing hardware. Every ballot
+ * selects exactly one option, ballot i choosing option i mod the number
+ * of selections, and one ballot in SPOIL_RATE is spoiled rather than
+ * cast, so the decrypted tally can be checked against the expected
+ * counts. */
+
+#ifndef ELECTIONGUARD_VERSION
+#define ELECTIONGUARD_VERSION "unknown"
+#endif
+
+// One ballot in this many is spoiled
+#define SPOIL_RATE 10
+
+struct election_options
+{
+    uint32_t num_trustees;
+    uint32_t threshold;
+    uint32_t num_decrypting_trustees;
+    uint32_t num_selections;
+    uint32_t num_ballots;
+    const char *work_path;
+    const char *output_filename;
+};
+
+struct phase
+{
+    const char *name;
+    uint64_t items;
+    double seconds;
+};
+
+enum PHASES_e
+{
+    PHASE_CREATE_ELECTION,
+    PHASE_ENCRYPT_BALLOTS,
+    PHASE_LOAD_BALLOTS,
+    PHASE_RECORD_BALLOTS,
+    PHASE_TALLY_VOTES,
+    NUM_PHASES
+};
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [-t trustees] [-k threshold] [-d decrypting_trustees]\n"
+            "          [-s selections] [-b ballots] [-w work_path] "
+            "[-o output.json]\n",
+            program);
+}
+
+static bool parse_uint32(const char *arg, uint32_t *out)
+{
+    char *end;
+    unsigned long value = strtoul(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || value > UINT32_MAX)
+        return false;
+    *out = (uint32_t)value;
+    return true;
+}
+
+static bool parse_options(int argc, char **argv, struct election_options *options)
+{
+    bool ok = true;
+    bool decrypting_given = false;
+
+    for (int i = 1; i < argc && ok; i += 2)
+    {
+        const char *flag = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL || flag[0] != '-' || flag[1] == '\0' || flag[2] != '\0')
+            ok = false;
+        else if (flag[1] == 't')
+            ok = parse_uint32(value, &options->num_trustees);
+        else if (flag[1] == 'k')
+            ok = parse_uint32(value, &options->threshold);
+        else if (flag[1] == 'd')
+            ok = decrypting_given =
+                parse_uint32(value, &options->num_decrypting_trustees);
+        else if (flag[1] == 's')
+            ok = parse_uint32(value, &options->num_selections);
+        else if (flag[1] == 'b')
+            ok = parse_uint32(value, &options->num_ballots);
+        else if (flag[1] == 'w')
+            options->work_path = value;
+        else if (flag[1] == 'o')
+            options->output_filename = value;
+        else
+            ok = false;
+    }
+
+    if (ok && !decrypting_given)
+        options->num_decrypting_trustees = options->threshold;
+
+    if (ok && (options->num_trustees < 1 || options->num_trustees > MAX_TRUSTEES))
+    {
+        fprintf(stderr, "trustees must be between 1 and %d\n", MAX_TRUSTEES);
+        ok = false;
+    }
+    if (ok && (options->threshold < 1 || options->threshold > options->num_trustees))
+    {
+        fprintf(stderr, "threshold must be between 1 and the number of trustees\n");
+        ok = false;
+    }
+    if (ok && (options->num_decrypting_trustees < options->threshold ||
+               options->num_decrypting_trustees > options->num_trustees))
+    {
+        fprintf(stderr, "decrypting trustees must be between the threshold "
+                        "and the number of trustees\n");
+        ok = false;
+    }
+    if (ok && (options->num_selections < 1 || options->num_selections > MAX_SELECTIONS))
+    {
+        fprintf(stderr, "selections must be between 1 and %d\n", MAX_SELECTIONS);
+        ok = false;
+    }
+    if (ok && options->num_ballots < 1)
+    {
+        fprintf(stderr, "ballots must be at least 1\n");
+        ok = false;
+    }
+
+    return ok;
+}
+
+static void print_report(FILE *out, const struct election_options *options,
+                         const struct phase *phases, bool ok)
+{
+    double total = 0;
+    for (int i = 0; i < NUM_PHASES; i++)
+        total += phases[i].seconds;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"electionguard_version\": \"%s\",\n", ELECTIONGUARD_VERSION);
+    fprintf(out,
+            "  \"config\": {\"num_trustees\": %" PRIu32 ", \"threshold\": %" PRIu32
+            ", \"num_decrypting_trustees\": %" PRIu32
+            ", \"num_selections\": %" PRIu32 ", \"num_ballots\": %" PRIu32 "},\n",
+            options->num_trustees, options->threshold,
+            options->num_decrypting_trustees, options->num_selections,
+            options->num_ballots);
+    fprintf(out, "  \"success\": %s,\n", ok ? "true" : "false");
+    fprintf(out, "  \"phases\": [\n");
+    for (int i = 0; i < NUM_PHASES; i++)
+    {
+        fprintf(out,
+                "    {\"name\": \"%s\", \"items\": %" PRIu64
+                ", \"seconds\": %.6f, \"items_per_second\": %.3f}%s\n",
+                phases[i].name, phases[i].items, phases[i].seconds,
+                phases[i].seconds > 0 ? phases[i].items / phases[i].seconds : 0,
+                i + 1 < NUM_PHASES ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+    fprintf(out, "  \"total_seconds\": %.6f\n", total);
+    fprintf(out, "}\n");
+}
+
+int main(int argc, char **argv)
+{
+    bool ok = true;
+
+    struct election_options options = {
+        .num_trustees = 3,
+        .threshold = 2,
+        .num_selections = 3,
+        .num_ballots = 100,
+        .work_path = "bench_election",
+        // the SDK logs to stdout, so the report goes to a file of its own
+        .output_filename = "bench_election.json",
+    };
+
+    if (!parse_options(argc, argv, &options))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct phase phases[NUM_PHASES] = {
+        [PHASE_CREATE_ELECTION] = {.name = "API_CreateElection", .items = 1},
+        [PHASE_ENCRYPT_BALLOTS] = {.name = "API_EncryptBallot", .items = options.num_ballots},
+        [PHASE_LOAD_BALLOTS] = {.name = "API_LoadBallots", .items = options.num_ballots},
+        [PHASE_RECORD_BALLOTS] = {.name = "API_RecordBallots", .items = options.num_ballots},
+        [PHASE_TALLY_VOTES] = {.name = "API_TallyVotes", .items = options.num_ballots},
+    };
+
+    char encrypted_path[FILENAME_MAX];
+    char recorded_path[FILENAME_MAX];
+    char tally_path[FILENAME_MAX];
+    snprintf(encrypted_path, FILENAME_MAX, "%s/encrypted/", options.work_path);
+    snprintf(recorded_path, FILENAME_MAX, "%s/recorded/", options.work_path);
+    snprintf(tally_path, FILENAME_MAX, "%s/tallies/", options.work_path);
+
+    uint32_t num_ballots = options.num_ballots;
+    uint32_t num_selections = options.num_selections;
+
+    char **external_identifiers = calloc(num_ballots, sizeof(char *));
+    char **trackers = calloc(num_ballots, sizeof(char *));
+    struct register_ballot_message *encrypted_ballots =
+        calloc(num_ballots, sizeof(struct register_ballot_message));
+    char **loaded_identifiers = calloc(num_ballots, sizeof(char *));
+    struct register_ballot_message *loaded_ballots =
+        calloc(num_ballots, sizeof(struct register_ballot_message));
+    char **cast_ids = calloc(num_ballots, sizeof(char *));
+    char **spoil_ids = calloc(num_ballots, sizeof(char *));
+    char **cast_trackers = calloc(num_ballots, sizeof(char *));
+    char **spoil_trackers = calloc(num_ballots, sizeof(char *));
+    uint8_t *selections = calloc(num_selections, sizeof(uint8_t));
+    uint32_t *expected_tally = calloc(num_selections, sizeof(uint32_t));
+    uint32_t *tally = calloc(num_selections, sizeof(uint32_t));
+
+    if (external_identifiers == NULL || trackers == NULL ||
+        encrypted_ballots == NULL || loaded_identifiers == NULL ||
+        loaded_ballots == NULL || cast_ids == NULL || spoil_ids == NULL ||
+        cast_trackers == NULL || spoil_trackers == NULL || selections == NULL ||
+        expected_tally == NULL || tally == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        ok = false;
+    }
+
+    // Create Election
+
+    struct api_config config = {
+        .num_selections = num_selections,
+        .num_trustees = options.num_trustees,
+        .threshold = options.threshold,
+        .subgroup_order = 0,
+        .election_meta = "bench_election",
+        .joint_key = {.bytes = NULL},
+    };
+    struct trustee_state trustee_states[MAX_TRUSTEES];
+    bool created = false;
+
+    if (ok)
+    {
+        double start = now_seconds();
+        ok = created = API_CreateElection(&config, trustee_states);
+        phases[PHASE_CREATE_ELECTION].seconds = now_seconds() - start;
+        if (!ok)
+            fprintf(stderr, "API_CreateElection failed\n");
+    }
+
+    // Encrypt Ballots
+
+    char *encrypted_filename = NULL;
+    uint32_t num_encrypted = 0;
+
+    if (ok)
+        ok = API_EncryptBallot_soft_delete_file(encrypted_path, "ballots");
+
+    if (ok)
+    {
+        double start = now_seconds();
+        for (uint32_t i = 0; i < num_ballots && ok; i++)
+        {
+            external_identifiers[i] = malloc(MAX_EXTERNAL_ID_LENGTH);
+            if (external_identifiers[i] == NULL)
+            {
+                ok = false;
+                break;
+            }
+            snprintf(external_identifiers[i], MAX_EXTERNAL_ID_LENGTH,
+                     "ballot-%" PRIu32, i);
+
+            memset(selections, 0, num_selections);
+            selections[i % num_selections] = 1;
+
+            // each call after the first appends to the same file
+            char *filename = NULL;
+            ok = API_EncryptBallot(selections, 1, config,
+                                   external_identifiers[i],
+                                   &encrypted_ballots[i], encrypted_path,
+                                   "ballots", &filename, &trackers[i]);
+            if (ok)
+                num_encrypted++;
+            if (encrypted_filename == NULL)
+                encrypted_filename = filename;
+            else
+                free(filename);
+        }
+        phases[PHASE_ENCRYPT_BALLOTS].seconds = now_seconds() - start;
+        if (!ok)
+            fprintf(stderr, "API_EncryptBallot failed\n");
+    }
+
+    // Load Ballots, as a voting coordinator on another device would
+
+    if (ok)
+    {
+        double start = now_seconds();
+        ok = API_LoadBallots(0, num_ballots, num_selections, encrypted_filename,
+                             loaded_identifiers, loaded_ballots) ==
+             API_LOADBALLOTS_SUCCESS;
+        phases[PHASE_LOAD_BALLOTS].seconds = now_seconds() - start;
+        if (!ok)
+            fprintf(stderr, "API_LoadBallots failed\n");
+    }
+
+    // Record Ballots
+
+    uint32_t num_cast = 0;
+    uint32_t num_spoiled = 0;
+    char *recorded_filename = NULL;
+
+    for (uint32_t i = 0; i < num_ballots && ok; i++)
+    {
+        if (i % SPOIL_RATE == SPOIL_RATE - 1)
+            spoil_ids[num_spoiled++] = external_identifiers[i];
+        else
+        {
+            cast_ids[num_cast++] = external_identifiers[i];
+            expected_tally[i % num_selections]++;
+        }
+    }
+
+    if (ok)
+    {
+        double start = now_seconds();
+        ok = API_RecordBallots(num_selections, num_cast, num_spoiled,
+                               num_ballots, cast_ids, spoil_ids,
+                               external_identifiers, encrypted_ballots,
+                               recorded_path, "ballots", &recorded_filename,
+                               cast_trackers, spoil_trackers);
+        phases[PHASE_RECORD_BALLOTS].seconds = now_seconds() - start;
+        if (!ok)
+            fprintf(stderr, "API_RecordBallots failed\n");
+    }
+
+    // Tally Votes
+
+    char *tally_filename = NULL;
+
+    if (ok)
+    {
+        double start = now_seconds();
+        ok = API_TallyVotes(config, trustee_states,
+                            options.num_decrypting_trustees, recorded_filename,
+                            tally_path, "tally", &tally_filename, tally);
+        phases[PHASE_TALLY_VOTES].seconds = now_seconds() - start;
+        if (!ok)
+            fprintf(stderr, "API_TallyVotes failed\n");
+    }
+
+    for (uint32_t i = 0; i < num_selections && ok; i++)
+    {
+        if (tally[i] != expected_tally[i])
+        {
+            fprintf(stderr,
+                    "selection %" PRIu32 ": expected %" PRIu32 ", tallied %" PRIu32 "\n",
+                    i, expected_tally[i], tally[i]);
+            ok = false;
+        }
+    }
+
+    // Report
+
+    FILE *out = fopen(options.output_filename, "w");
+    if (out == NULL)
+    {
+        perror(options.output_filename);
+        out = stderr;
+    }
+    print_report(out, &options, phases, ok);
+    if (out != stderr)
+        fclose(out);
+
+    // Clean up
+
+    API_TallyVotes_free(tally_filename);
+    if (recorded_filename != NULL)
+        API_RecordBallots_free(recorded_filename, num_cast, num_spoiled,
+                               cast_trackers, spoil_trackers);
+
+    for (uint32_t i = 0; i < num_ballots && loaded_identifiers != NULL; i++)
+    {
+        free(loaded_identifiers[i]);
+        if (loaded_ballots != NULL && loaded_ballots[i].bytes != NULL)
+            API_EncryptBallot_free(loaded_ballots[i], NULL);
+    }
+    API_LoadBallots_free(encrypted_filename);
+
+    for (uint32_t i = 0; i < num_encrypted; i++)
+        API_EncryptBallot_free(encrypted_ballots[i], trackers[i]);
+    for (uint32_t i = 0; i < num_ballots && external_identifiers != NULL; i++)
+        free(external_identifiers[i]);
+
+    if (created)
+        API_CreateElection_free(config.joint_key, trustee_states);
+
+    free(external_identifiers);
+    free(trackers);
+    free(encrypted_ballots);
+    free(loaded_identifiers);
+    free(loaded_ballots);
+    free(cast_ids);
+    free(spoil_ids);
+    free(cast_trackers);
+    free(spoil_trackers);
+    free(selections);
+    free(expected_tally);
+    free(tally);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <gmp.h>
+
+#include "bignum.h"
+#include "crypto_reps.h"
+#include "random_source.h"
+#include "sha2-openbsd.h"
+#include "uint4096.h"
+
+/* Timings of the bignum and proof primitives, written as JSON so that
+ * results can be compared across releases. The inputs come from a fixed
+ * seed, and each benchmark runs a fixed number of iterations, so two runs
+ * of the same build do the same work. The randomness the primitives draw
+ * for themselves (nonces and fake challenges) still comes from the
+ * system. */
+
+#ifndef ELECTIONGUARD_VERSION
+#define ELECTIONGUARD_VERSION "unknown"
+#endif
+
+// Distinct inputs each benchmark cycles through
+#define NUM_INPUTS 16
+// Runs of each benchmark, of which the median and minimum are reported
+#define NUM_SAMPLES 7
+// Logs up to this are found by the log_generator_mod_p benchmark
+#define MAX_LOG 1000000
+
+static RandomSource source;
+static struct joint_public_key_rep key;
+static struct Crypto_fixed_bases bases;
+static struct hash base_hash;
+static struct dlog_table dlog_table;
+
+static mpz_t elements[NUM_INPUTS];
+static mpz_t exponents[NUM_INPUTS];
+static struct uint4096_s elements_4096[NUM_INPUTS];
+static struct uint4096_s exponents_4096[NUM_INPUTS];
+static mpz_t messages[NUM_INPUTS];
+static mpz_t nonces[NUM_INPUTS];
+static struct encryption_rep encryptions[NUM_INPUTS];
+static struct dis_proof_rep dis_proofs[NUM_INPUTS];
+static mpz_t powers[NUM_INPUTS];
+
+static mpz_t scratch;
+static mpz_t scratch_nonce;
+static struct uint4096_s scratch_4096;
+static struct encryption_rep scratch_encryption;
+static struct dis_proof_rep scratch_dis_proof;
+static struct cp_proof_rep scratch_cp_proof;
+
+static volatile bool sink;
+
+static void uint4096_from_mpz(uint4096 out, const mpz_t op)
+{
+    size_t count = (mpz_sizeinbase(op, 2) + 63) / 64;
+    for (size_t i = 0; i < UINT4096_WORD_COUNT - count; i++)
+        out->words[i] = 0;
+    mpz_export(&out->words[UINT4096_WORD_COUNT - count], NULL, 1, 8, 0, 0, op);
+}
+
+static bool setup(void)
+{
+    bool ok = true;
+
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    gmp_randseed_ui(state, 20200410);
+
+    Crypto_parameters_new();
+
+    struct RandomSource_new_r source_r = RandomSource_new();
+    if (source_r.status != RANDOM_SOURCE_SUCCESS)
+        ok = false;
+    else
+        source = source_r.source;
+
+    if (ok)
+    {
+        mpz_t secret_key;
+        mpz_init(secret_key);
+        mpz_urandomm(secret_key, state, q);
+        Crypto_joint_public_key_init(&key);
+        key.num_trustees = 1;
+        pow_mod_p(key.public_key, generator, secret_key);
+        mpz_clear(secret_key);
+
+        mpz_init(base_hash.digest);
+        mpz_urandomm(base_hash.digest, state, q);
+
+        if (Crypto_fixed_bases_new(&bases, key.public_key) != CRYPTO_SUCCESS)
+            ok = false;
+    }
+
+    if (ok && dlog_table_new(&dlog_table, MAX_LOG) != BIGNUM_SUCCESS)
+        ok = false;
+
+    for (uint32_t i = 0; ok && i < NUM_INPUTS; i++)
+    {
+        mpz_init(elements[i]);
+        mpz_urandomm(elements[i], state, p);
+        uint4096_from_mpz(&elements_4096[i], elements[i]);
+
+        mpz_init(exponents[i]);
+        mpz_urandomm(exponents[i], state, q);
+        uint4096_from_mpz(&exponents_4096[i], exponents[i]);
+
+        mpz_init_set_ui(messages[i], i % 2);
+        mpz_init(nonces[i]);
+        Crypto_encryption_rep_new(&encryptions[i]);
+        Crypto_encrypt(&encryptions[i], nonces[i], source, &key, &bases,
+                       messages[i]);
+
+        Crypto_dis_proof_new(&dis_proofs[i]);
+        Crypto_generate_dis_proof(&dis_proofs[i], source, base_hash, i % 2,
+                                  key.public_key, &bases, encryptions[i],
+                                  nonces[i]);
+
+        mpz_init(powers[i]);
+        mpz_set_ui(powers[i], gmp_urandomm_ui(state, MAX_LOG + 1));
+        pow_mod_p(powers[i], generator, powers[i]);
+    }
+
+    mpz_init(scratch);
+    mpz_init(scratch_nonce);
+    Crypto_encryption_rep_new(&scratch_encryption);
+    Crypto_dis_proof_new(&scratch_dis_proof);
+    Crypto_cp_proof_new(&scratch_cp_proof);
+
+    gmp_randclear(state);
+
+    return ok;
+}
+
+static void bench_pow_mod_p(uint32_t i)
+{
+    pow_mod_p(scratch, elements[i], exponents[i]);
+}
+
+static void bench_pow_mod_p_fixed(uint32_t i)
+{
+    pow_mod_p_fixed(scratch, &bases.generator, exponents[i]);
+}
+
+static void bench_mul_mod_p(uint32_t i)
+{
+    mul_mod_p(scratch, elements[i], elements[(i + 1) % NUM_INPUTS]);
+}
+
+static void bench_uint4096_powmod_o(uint32_t i)
+{
+    uint4096_powmod_o(&scratch_4096, &elements_4096[i], &exponents_4096[i],
+                      Modulus4096_modulus_default);
+}
+
+static void bench_Crypto_encrypt(uint32_t i)
+{
+    Crypto_encrypt(&scratch_encryption, scratch_nonce, source, &key, &bases,
+                   messages[i]);
+}
+
+static void bench_Crypto_generate_dis_proof(uint32_t i)
+{
+    Crypto_generate_dis_proof(&scratch_dis_proof, source, base_hash, i % 2,
+                              key.public_key, &bases, encryptions[i], nonces[i]);
+}
+
+static void bench_Crypto_check_dis_proof(uint32_t i)
+{
+    sink = Crypto_check_dis_proof(dis_proofs[i], encryptions[i], base_hash,
+                                  key.public_key, &bases);
+}
+
+static void bench_Crypto_generate_aggregate_cp_proof(uint32_t i)
+{
+    Crypto_generate_aggregate_cp_proof(&scratch_cp_proof, source, nonces[i],
+                                       encryptions[i], base_hash,
+                                       key.public_key, &bases);
+    // the challenge is initialized by each call
+    mpz_clear(scratch_cp_proof.challenge.digest);
+}
+
+static void bench_log_generator_mod_p(uint32_t i)
+{
+    sink = log_generator_mod_p(scratch, powers[i], &dlog_table);
+}
+
+static void bench_sha256_bignum_p(uint32_t i)
+{
+    SHA2_CTX context;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256Init(&context);
+    Crypto_hash_update_bignum_p(&context, elements[i]);
+    SHA256Final(digest, &context);
+    sink = digest[0];
+}
+
+struct benchmark
+{
+    const char *name;
+    uint32_t iterations;
+    void (*run)(uint32_t i);
+};
+
+static const struct benchmark benchmarks[] = {
+    {"pow_mod_p", 32, bench_pow_mod_p},
+    {"pow_mod_p_fixed", 512, bench_pow_mod_p_fixed},
+    {"mul_mod_p", 8192, bench_mul_mod_p},
+    {"uint4096_powmod_o", 4, bench_uint4096_powmod_o},
+    {"Crypto_encrypt", 128, bench_Crypto_encrypt},
+    {"Crypto_generate_dis_proof", 32, bench_Crypto_generate_dis_proof},
+    {"Crypto_check_dis_proof", 16, bench_Crypto_check_dis_proof},
+    {"Crypto_generate_aggregate_cp_proof", 32,
+     bench_Crypto_generate_aggregate_cp_proof},
+    {"log_generator_mod_p", 64, bench_log_generator_mod_p},
+    {"sha256_bignum_p", 16384, bench_sha256_bignum_p},
+};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *out = stdout;
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [output.json]\n", argv[0]);
+        return 1;
+    }
+    if (argc == 2)
+    {
+        out = fopen(argv[1], "w");
+        if (out == NULL)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    if (!setup())
+    {
+        fprintf(stderr, "bench_primitives: setup failed\n");
+        return 1;
+    }
+
+    size_t num_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"electionguard_version\": \"%s\",\n", ELECTIONGUARD_VERSION);
+    fprintf(out, "  \"gmp_version\": \"%s\",\n", gmp_version);
+    fprintf(out, "  \"samples\": %d,\n", NUM_SAMPLES);
+    fprintf(out, "  \"benchmarks\": [\n");
+
+    for (size_t b = 0; b < num_benchmarks; b++)
+    {
+        const struct benchmark *bench = &benchmarks[b];
+        double samples[NUM_SAMPLES];
+
+        // warm up caches and the allocator
+        bench->run(0);
+
+        for (int s = 0; s < NUM_SAMPLES; s++)
+        {
+            double start = now_ns();
+            for (uint32_t i = 0; i < bench->iterations; i++)
+                bench->run(i % NUM_INPUTS);
+            samples[s] = (now_ns() - start) / bench->iterations;
+        }
+        qsort(samples, NUM_SAMPLES, sizeof(double), compare_doubles);
+
+        fprintf(out,
+                "    {\"name\": \"%s\", \"iterations\": %" PRIu32
+                ", \"min_ns\": %.0f, \"median_ns\": %.0f, \"max_ns\": %.0f}%s\n",
+                bench->name, bench->iterations, samples[0],
+                samples[NUM_SAMPLES / 2], samples[NUM_SAMPLES - 1],
+                b + 1 < num_benchmarks ? "," : "");
+        fflush(out);
+    }
+
+    fprintf(out, "  ]\n}\n");
+
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
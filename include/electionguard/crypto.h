@@ -47,6 +47,26 @@ struct hash {
     mpz_t digest;
 };
 
+/**
+ * How much of the proofs it generates a component checks itself before
+ * handing them out. A failed check means a bug in the SDK, so production
+ * can trade these checks for speed. */
+enum Crypto_verification_policy
+{
+    /** Check every proof as it is made. The default. */
+    CRYPTO_VERIFY_ALWAYS,
+    /** Check one in CRYPTO_VERIFY_SAMPLE_RATE of the proofs as they are made. */
+    CRYPTO_VERIFY_SAMPLED,
+    /** Keep the proofs as they are made, and check them all together when
+     *  the component is asked to. */
+    CRYPTO_VERIFY_DEFERRED,
+};
+
+enum CRYPTO_VERIFY_SAMPLE_RATE_e
+{
+    CRYPTO_VERIFY_SAMPLE_RATE = 16,
+};
+
 /** You must call this before any of the other SDK functions. */
 void Crypto_parameters_new();
 
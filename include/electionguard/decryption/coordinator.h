@@ -97,6 +97,38 @@ enum Decryption_Coordinator_status
 Decryption_Coordinator_receive_fragments(Decryption_Coordinator c,
                                          struct decryption_fragments fragments);
 
+/****************************** DISCRETE LOGS *******************************/
+
+/* The largest tally recovered when no table has been built or read. Its
+ * table has 2,237 entries and takes as many multiplications to build. */
+#define DECRYPTION_COORDINATOR_DEFAULT_MAX_TALLY 5000000
+
+/**
+ * Precompute the table used to recover each tally from g^tally, for
+ * tallies of up to max_tally. It takes about sqrt(max_tally)
+ * multiplications to build and as many to recover each tally. Without
+ * one, a table for DECRYPTION_COORDINATOR_DEFAULT_MAX_TALLY is built when
+ * all fragments are received.
+ */
+enum Decryption_Coordinator_status
+Decryption_Coordinator_build_dlog_table(Decryption_Coordinator c,
+                                        uint64_t max_tally);
+
+/**
+ * Use a table saved by Decryption_Coordinator_write_dlog_table, so that
+ * large elections need not build it again. Fails with
+ * DECRYPTION_COORDINATOR_IO_ERROR if the table is malformed or belongs to
+ * other group parameters.
+ */
+enum Decryption_Coordinator_status
+Decryption_Coordinator_read_dlog_table(Decryption_Coordinator c, FILE *in);
+
+/**
+ * Save the coordinator's table, building the default one if needed.
+ */
+enum Decryption_Coordinator_status
+Decryption_Coordinator_write_dlog_table(Decryption_Coordinator c, FILE *out);
+
 // @todo jwaksbaum Do we want to return the number of bytes written?
 
 /**
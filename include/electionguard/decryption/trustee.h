@@ -19,6 +19,7 @@ enum Decryption_Trustee_status
     DECRYPTION_TRUSTEE_MALFORMED_INPUT,
     DECRYPTION_TRUSTEE_SERIALIZE_ERROR,
     DECRYPTION_TRUSTEE_DESERIALIZE_ERROR,
+    DECRYPTION_TRUSTEE_PROOF_ERROR,
 };
 
 /************************** INITIALIZATION & FREEING ***************************/
@@ -48,12 +49,54 @@ struct Decryption_Trustee_new_r
 /** Free a trustee. */
 void Decryption_Trustee_free(Decryption_Trustee d);
 
+/**
+ * Choose when the trustee checks the decryption proofs it makes: every
+ * time (the default), one in CRYPTO_VERIFY_SAMPLE_RATE, or only when
+ * Decryption_Trustee_verify_deferred is called. A failed check makes
+ * the share or fragments fail with DECRYPTION_TRUSTEE_PROOF_ERROR.
+ */
+void Decryption_Trustee_set_verification_policy(
+    Decryption_Trustee d, enum Crypto_verification_policy policy);
+
+/**
+ * Check the proofs kept back under CRYPTO_VERIFY_DEFERRED, and let
+ * them go. Decryption shares do not carry their proofs, so under that
+ * policy this is the only check they get.
+ */
+enum Decryption_Trustee_status
+Decryption_Trustee_verify_deferred(Decryption_Trustee d);
+
 /********************************* TALLYING **********************************/
 
-/** Parse a voting record, tally it, and store the encrypted tally of all the votes. */
+/** Parse a voting record, tally it, and store the encrypted tally of all the votes.
+ *  The record may be text, or a binary ballot file written by
+ *  Voting_Coordinator_export_buffered_ballots_binary. */
 enum Decryption_Trustee_status
 Decryption_Trustee_tally_voting_record(Decryption_Trustee d, FILE *in);
 
+/**
+ * Tally the voting record in the file filename, as with
+ * Decryption_Trustee_tally_voting_record, but split the ballots into
+ * num_shards byte ranges. Each range is parsed and accumulated into a
+ * partial tally on its own thread, and the partial tallies are then
+ * combined. The tally is left unchanged if any range fails. */
+enum Decryption_Trustee_status
+Decryption_Trustee_tally_voting_record_sharded(Decryption_Trustee d,
+                                               const char *filename,
+                                               uint32_t num_shards);
+
+/**
+ * Replace d's tally with the tally of source, so that trustees given the
+ * same voting record only parse it once. The trustees must be for the same
+ * number of selections. */
+enum Decryption_Trustee_status
+Decryption_Trustee_copy_tally(Decryption_Trustee d, Decryption_Trustee source);
+
+/**
+ * The number of ballots, cast or spoiled, in the voting records d has
+ * tallied. No selection's tally can be larger. */
+uint64_t Decryption_Trustee_num_ballots(Decryption_Trustee d);
+
 /********************************* ANNOUNCING **********************************/
 
 /** Decrypt this trustee's share of the tally. */
@@ -19,18 +19,18 @@ enum MAX_TRUSTEES_e
 };
 
 /**
- * The maximum number of ballots that can be 
- * cast at one time by a voting single coordinator. 
+ * Ballot counts used as defaults. A voting coordinator's buffer grows as
+ * ballots are registered, so neither is a hard limit.
  */
 enum MAX_BALLOTS_e
 {
-    /** The Maximum ballots for an election 
-     * that one Voting Coordinator can track
+    /** The ballots for an election
+     * that one Voting Coordinator is sized for
      */
     MAX_BALLOTS = 10000,
 
-    /** The Maximum ballots that can be passed 
-     * to a Voting Coordinator for 
+    /** A suggested number of ballots to pass
+     * to a Voting Coordinator for
      * Registration, Casting, or Spoiling at one time
      */
     MAX_BALLOT_PAYLOAD = 2000
@@ -1,6 +1,8 @@
 #ifndef _RSA_H
 #define _RSA_H
 
+#include <stdbool.h>
+
 #define MODULUS_SIZE 4096                   /* This is the number of bits we want in the modulus */
 #define BUFFER_SIZE ((MODULUS_SIZE/8) / 2)  /* This is the number of bytes in n and p */
 #define BLOCK_SIZE (MODULUS_SIZE/8)         /* This is the size of a block that gets en/decrypted at once */
@@ -19,7 +21,9 @@ typedef struct {
     mpz_t q;                                            // Starting prime q
 } rsa_private_key;
 
-void generate_keys(rsa_private_key* priv_key, rsa_public_key* pub_key);
+/* Returns false, and the keys must not be used, if no random bytes could
+ * be had */
+bool generate_keys(rsa_private_key* priv_key, rsa_public_key* pub_key);
 
 void RSA_Encrypt(mpz_t encrypted, mpz_t message, rsa_public_key* pub_key);
 
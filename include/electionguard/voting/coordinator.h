@@ -41,9 +41,10 @@ enum Voting_Coordinator_status
  * This component mutates the state of votes by handling loading ballots,
  * registering them, marking them as cast, or spoiled, and caching the state.
  * 
- * The Voting Coordinator can track the state of:
- * -- MAX_BALLOTS it can hold in memory and
- * -- MAX_BALLOT_PAYLOAD selections and trackers it can buffer before writing to cache
+ * The Voting Coordinator tracks the state of every ballot registered with
+ * it, and buffers the selections and trackers of each until they are
+ * exported. The buffer grows in chunks as ballots are registered; use
+ * Voting_Coordinator_set_max_ballots to bound it.
  * 
  * @param uint32_t num_selections the total number of selections 
  *                                available on the ballot
@@ -64,6 +65,14 @@ struct Voting_Coordinator_new_r
  */
 void Voting_Coordinator_free(Voting_Coordinator coordinator);
 
+/**
+ * Limit the number of ballots the coordinator tracks. Registering more
+ * fails with VOTING_COORDINATOR_INVALID_BALLOT_INDEX. 0, the default,
+ * means no limit.
+ */
+void Voting_Coordinator_set_max_ballots(Voting_Coordinator coordinator,
+                                        uint64_t max_ballots);
+
 /**
  * Clear the selections buffer and drop instance references to any external id's
  */
@@ -106,16 +115,39 @@ char *Voting_Coordinator_get_tracker(Voting_Coordinator coordinator,
 /** 
  * Write all of the cast and spoiled ballots to out to the specified file.
  * Clears the Voting Coordinator buffer in the process
+ *
+ * If out already holds ballots, the new ones are appended after them and
+ * the count in its header is updated, without reading the ballots back,
+ * so out must be opened for update rather than append. A file from an
+ * older release, whose count is not zero-padded to a fixed width, is first
+ * migrated: its ballots are counted and moved up to make room for a
+ * fixed-width count.
  */
 enum Voting_Coordinator_status
 Voting_Coordinator_export_buffered_ballots(Voting_Coordinator coordinator, FILE *out);
 
+/**
+ * Write the cast and spoiled ballots to out like
+ * Voting_Coordinator_export_buffered_ballots, but as a binary ballot file
+ * of fixed size records, which the decryption trustees read without
+ * parsing any text. The ballots are added to any already in out, which
+ * must then be open for reading and writing.
+ */
+enum Voting_Coordinator_status
+Voting_Coordinator_export_buffered_ballots_binary(Voting_Coordinator coordinator,
+                                                  FILE *out);
+
 /**
  * Import ballots from the specified file.  Expects a file that was build
  * With the Voting Encrypter using the format:
  *      <ballot_id> TAB <encrypted_ballot_message> \n
+ * or a binary ballot file. Ballots are counted from 0, and the ones
+ * before start_index in a text file are read past; use
+ * Voting_Coordinator_import_encrypted_ballots_at to start from an offset
+ * instead. The outputs are indexed from 0 for ballot start_index.
  * 
  * @see Voting_Encrypter_write_ballot
+ * @see Voting_Encrypter_write_ballot_binary
  * @param Voting_Coordinator coordinator the voting coordinator instance
  * @param uint64_t start_index the start index to import form the file
  * @param uint64_t count the count of ballots to import
@@ -133,4 +165,21 @@ Voting_Coordinator_import_encrypted_ballots(Voting_Coordinator coordinator,
                                             char **out_external_identifiers,
                                             struct register_ballot_message *out_messages);
 
+/**
+ * Import ballots from a text ballot file like
+ * Voting_Coordinator_import_encrypted_ballots, where ballot start_index is
+ * known to begin at byte offset, such as from the file's index. Ballots
+ * at different offsets may be imported at the same time from different
+ * handles on the file.
+ */
+enum Voting_Coordinator_status
+Voting_Coordinator_import_encrypted_ballots_at(Voting_Coordinator coordinator,
+                                               uint64_t start_index,
+                                               uint64_t offset,
+                                               uint64_t count,
+                                               uint32_t num_selections,
+                                               FILE *in,
+                                               char **out_external_identifiers,
+                                               struct register_ballot_message *out_messages);
+
 #endif /* __VOTING_COORDINATOR_H__ */
@@ -46,6 +46,53 @@ struct Voting_Encrypter_new_r
 /** Free a ballot marking device. */
 void Voting_Encrypter_free(Voting_Encrypter encrypter);
 
+/**
+ * Start a background thread that keeps up to pool_size selections' worth
+ * of exponentiations computed ahead of time, so that encrypting a ballot
+ * while the pool lasts takes only a few multiplications per selection.
+ * Encryptions fall back to computing their own when the pool is empty.
+ * Does nothing if the encrypter is already precomputing. */
+enum Voting_Encrypter_status
+Voting_Encrypter_start_precomputing(Voting_Encrypter encrypter,
+                                    uint32_t pool_size);
+
+/** Stop the background thread and discard the pool, if there is one. */
+void Voting_Encrypter_stop_precomputing(Voting_Encrypter encrypter);
+
+/**
+ * Set how many of the ballots it encrypts the encrypter checks the proofs
+ * of. Under CRYPTO_VERIFY_DEFERRED the proofs of each ballot are kept
+ * until Voting_Encrypter_verify_deferred is called. */
+void Voting_Encrypter_set_verification_policy(
+    Voting_Encrypter encrypter, enum Crypto_verification_policy policy);
+
+/**
+ * Check the proofs of every ballot encrypted under CRYPTO_VERIFY_DEFERRED
+ * since the last call, and discard them. Returns
+ * VOTING_ENCRYPTER_UNKNOWN_ERROR if any of them fail. Must not be called
+ * while the encrypter is encrypting on another thread. */
+enum Voting_Encrypter_status
+Voting_Encrypter_verify_deferred(Voting_Encrypter encrypter);
+
+/**
+ * Write a line to out holding the encryptions and proofs of each ballot
+ * the encrypter encrypts from now on, for Voting_Encrypter_audit_proofs to
+ * check later. Pass NULL to stop. Does not take ownership of out, which
+ * must stay open while the encrypter encrypts. */
+void Voting_Encrypter_set_proofs_file(Voting_Encrypter encrypter, FILE *out);
+
+/**
+ * Check every proof in a file written through
+ * Voting_Encrypter_set_proofs_file by any encrypter of the same election,
+ * without trusting whoever wrote it. Sets out_num_ballots to the number of
+ * ballots in the file and out_num_invalid to the number of those with a
+ * proof that fails. Returns VOTING_ENCRYPTER_DESERIALIZE_ERROR if the file
+ * is malformed. */
+enum Voting_Encrypter_status
+Voting_Encrypter_audit_proofs(Voting_Encrypter encrypter, FILE *in,
+                              uint64_t *out_num_ballots,
+                              uint64_t *out_num_invalid);
+
 /***************************** BALLOT ENCRYPTION ******************************/
 
 // @todo jwaksbaum How do we want to represent an unencrypted ballot?
@@ -73,6 +120,22 @@ struct Voting_Encrypter_encrypt_ballot_r
     struct ballot_tracker tracker;
     struct ballot_identifier id;
 };
+/**
+ * Encrypt num_ballots ballots at once, spreading the selections of every
+ * ballot over num_threads threads (the calling thread included), each with
+ * its own source of randomness. The arguments are parallel arrays, each
+ * element as for Voting_Encrypter_encrypt_ballot, and out_results must have
+ * room for num_ballots results. Ballot ids are assigned in the order the
+ * ballots are given. Returns the status of the first ballot that failed, or
+ * VOTING_ENCRYPTER_SUCCESS; the status of each ballot is in its result. The
+ * encrypter must not be used by another thread during the call. */
+enum Voting_Encrypter_status
+Voting_Encrypter_encrypt_ballots_parallel(
+    Voting_Encrypter encrypter, uint32_t num_ballots,
+    char *const *external_identifiers, bool const *const *selections,
+    uint32_t const *expected_num_selected, uint32_t num_threads,
+    struct Voting_Encrypter_encrypt_ballot_r *out_results);
+
 bool Validate_selections(
     bool const *selections, uint32_t num_selections, uint32_t expected_num_selected);
 
@@ -83,4 +146,13 @@ enum Voting_Encrypter_status
 Voting_Encrypter_write_ballot(FILE *out, char *external_identifier,
                                 struct register_ballot_message *encrypted_ballot_message);
 
+/** Write a single ballot to out like Voting_Encrypter_write_ballot, but as
+ *  a record of a binary ballot file, starting the file if out is empty.
+ *  out must be open for reading and writing, and not in append mode, since
+ *  the count of ballots at the start of the file is updated.
+ */
+enum Voting_Encrypter_status
+Voting_Encrypter_write_ballot_binary(FILE *out, char *external_identifier,
+                                     struct register_ballot_message *encrypted_ballot_message);
+
 #endif /* __VOTING_ENCRYPTER_H__ */
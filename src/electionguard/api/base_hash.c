@@ -1,5 +1,7 @@
 #include "api/base_hash.h"
 
+raw_hash base_hash_code;
+
 void create_base_hash_code(struct api_config config)
 {
     // This is a temporary placeholder. In a real election, this should be
@@ -10,8 +10,8 @@
 #include <electionguard/max_values.h>
 #include <electionguard/api/config.h>
 
-// Globally available
-raw_hash base_hash_code;
+// Globally available, defined in base_hash.c
+extern raw_hash base_hash_code;
 
 void create_base_hash_code(struct api_config config);
 
@@ -1,3 +1,5 @@
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -5,11 +7,17 @@
 #include <log.h>
 
 #include "api/base_hash.h"
+#include "processors.h"
 
 // Initialize
 static bool initialize_coordinator(void);
 static bool initialize_trustees(void);
 
+// Run the work of each trustee, on as many threads as there are
+// processors, the trustees being independent of each other
+static bool run_trustees(bool (*work)(uint32_t index, const void *in_message),
+                         const void *in_message);
+
 // Key Generation
 static bool generate_keys(void);
 static struct all_keys_received_message receive_keys(void);
@@ -30,6 +38,9 @@ static bool export_trustee_states(struct trustee_state *trustee_states);
 static struct api_config api_config;
 static KeyCeremony_Coordinator _keyceremony_coordinator;
 static KeyCeremony_Trustee trustees[MAX_TRUSTEES];
+// Trustees hand their messages to the coordinator as they make them, so
+// it is only used by one at a time
+static pthread_mutex_t coordinator_lock = PTHREAD_MUTEX_INITIALIZER;
 
 bool API_CreateElection(struct api_config *config,
                         struct trustee_state *trustee_states)
@@ -204,46 +215,101 @@ bool initialize_trustees(void)
     return ok;
 }
 
-bool generate_keys(void)
+// Work shared by the threads of run_trustees, which claim trustees in turn
+// until there are none left or one of them fails
+struct trustee_pool
 {
-    bool ok = true;
+    bool (*work)(uint32_t index, const void *in_message);
+    const void *in_message;
+    atomic_uint next;
+    atomic_bool ok;
+};
 
-    for (uint32_t i = 0; i < api_config.num_trustees && ok; i++)
+static void *trustee_pool_run(void *arg)
+{
+    struct trustee_pool *pool = arg;
+
+    for (uint32_t i = atomic_fetch_add(&pool->next, 1);
+         i < api_config.num_trustees && atomic_load(&pool->ok);
+         i = atomic_fetch_add(&pool->next, 1))
     {
-        struct key_generated_message key_generated = {.bytes = NULL};
-        struct KeyCeremony_Trustee_generate_key_r result =
-            KeyCeremony_Trustee_generate_key(trustees[i], base_hash_code);
+        if (!pool->work(i, pool->in_message))
+            atomic_store(&pool->ok, false);
+    }
 
-        if (result.status != KEYCEREMONY_TRUSTEE_SUCCESS)
-        {
+    return NULL;
+}
+
+bool run_trustees(bool (*work)(uint32_t index, const void *in_message),
+                  const void *in_message)
+{
+    struct trustee_pool pool = {
+        .work = work,
+        .in_message = in_message,
+    };
+    atomic_init(&pool.next, 0);
+    atomic_init(&pool.ok, true);
+
+    uint32_t num_threads = Processors_count();
+    if (num_threads > api_config.num_trustees)
+        num_threads = api_config.num_trustees;
+
+    // The calling thread is one of them
+    pthread_t threads[MAX_TRUSTEES];
+    uint32_t num_started = 0;
+    for (uint32_t i = 1; i < num_threads; i++)
+        if (0 == pthread_create(&threads[num_started], NULL, trustee_pool_run,
+                                &pool))
+            num_started++;
+
+    trustee_pool_run(&pool);
+
+    for (uint32_t i = 0; i < num_started; i++)
+        pthread_join(threads[i], NULL);
+
+    return atomic_load(&pool.ok);
+}
+
+static bool generate_key(uint32_t i, const void *in_message)
+{
+    (void)in_message;
+
+    bool ok = true;
+
+    struct key_generated_message key_generated = {.bytes = NULL};
+    struct KeyCeremony_Trustee_generate_key_r result =
+        KeyCeremony_Trustee_generate_key(trustees[i], base_hash_code);
+
+    if (result.status != KEYCEREMONY_TRUSTEE_SUCCESS)
+        ok = false;
+    else
+        key_generated = result.message;
+
+    if (ok)
+    {
+        pthread_mutex_lock(&coordinator_lock);
+        enum KeyCeremony_Coordinator_status status =
+            KeyCeremony_Coordinator_receive_key_generated(
+                _keyceremony_coordinator, key_generated);
+        pthread_mutex_unlock(&coordinator_lock);
+        if (status != KEYCEREMONY_COORDINATOR_SUCCESS)
             ok = false;
-        }
-        else
-            key_generated = result.message;
-    
-        if (ok)
-        {
-            enum KeyCeremony_Coordinator_status status =
-                KeyCeremony_Coordinator_receive_key_generated(
-                    _keyceremony_coordinator,
-                    key_generated
-                );
-            if (status != KEYCEREMONY_COORDINATOR_SUCCESS)
-            {
-                ok = false;
-            }        
-        }
+    }
 
-        if (key_generated.bytes != NULL)
-        {
-            free((void *)key_generated.bytes);
-            key_generated.bytes = NULL;
-        }
+    if (key_generated.bytes != NULL)
+    {
+        free((void *)key_generated.bytes);
+        key_generated.bytes = NULL;
     }
 
     return ok;
 }
 
+bool generate_keys(void)
+{
+    return run_trustees(generate_key, NULL);
+}
+
 struct all_keys_received_message receive_keys(void)
 {
     struct all_keys_received_message message = {.bytes = NULL};
@@ -257,46 +323,46 @@ struct all_keys_received_message receive_keys(void)
     return message;
 }
 
-bool generate_shares(struct all_keys_received_message all_keys_received)
+static bool generate_trustee_shares(uint32_t i, const void *in_message)
 {
-    bool ok = true;
+    const struct all_keys_received_message *all_keys_received = in_message;
 
-    for (uint32_t i = 0; i < api_config.num_trustees && ok; i++)
-    {
-        struct shares_generated_message shares_generated = {.bytes = NULL};
+    bool ok = true;
 
-        {
-            struct KeyCeremony_Trustee_generate_shares_r result =
-                KeyCeremony_Trustee_generate_shares(trustees[i],
-                                                    all_keys_received);
+    struct shares_generated_message shares_generated = {.bytes = NULL};
+    struct KeyCeremony_Trustee_generate_shares_r result =
+        KeyCeremony_Trustee_generate_shares(trustees[i], *all_keys_received);
 
-            if (result.status != KEYCEREMONY_TRUSTEE_SUCCESS)
-                ok = false;
-            else
-            {
-                shares_generated = result.message;
-            }
-        }
+    if (result.status != KEYCEREMONY_TRUSTEE_SUCCESS)
+        ok = false;
+    else
+        shares_generated = result.message;
 
-        if (ok)
-        {
-            enum KeyCeremony_Coordinator_status cstatus =
-                KeyCeremony_Coordinator_receive_shares_generated(
-                    _keyceremony_coordinator, shares_generated);
-            if (cstatus != KEYCEREMONY_COORDINATOR_SUCCESS)
-                ok = false;
-        }
+    if (ok)
+    {
+        pthread_mutex_lock(&coordinator_lock);
+        enum KeyCeremony_Coordinator_status status =
+            KeyCeremony_Coordinator_receive_shares_generated(
+                _keyceremony_coordinator, shares_generated);
+        pthread_mutex_unlock(&coordinator_lock);
+        if (status != KEYCEREMONY_COORDINATOR_SUCCESS)
+            ok = false;
+    }
 
-        if (shares_generated.bytes != NULL)
-        {
-            free((void *)shares_generated.bytes);
-            shares_generated.bytes = NULL;
-        }
+    if (shares_generated.bytes != NULL)
+    {
+        free((void *)shares_generated.bytes);
+        shares_generated.bytes = NULL;
     }
 
     return ok;
 }
 
+bool generate_shares(struct all_keys_received_message all_keys_received)
+{
+    return run_trustees(generate_trustee_shares, &all_keys_received);
+}
+
 struct all_shares_received_message receive_shares()
 {
     struct all_shares_received_message message = {.bytes = NULL};
@@ -310,43 +376,46 @@ struct all_shares_received_message receive_shares()
     return message;
 }
 
-bool verify_shares(struct all_shares_received_message all_shares_received)
+static bool verify_trustee_shares(uint32_t i, const void *in_message)
 {
+    const struct all_shares_received_message *all_shares_received = in_message;
+
     bool ok = true;
 
-    for (uint32_t i = 0; i < api_config.num_trustees && ok; i++)
-    {
-        struct shares_verified_message shares_verified;
+    struct shares_verified_message shares_verified = {.bytes = NULL};
+    struct KeyCeremony_Trustee_verify_shares_r result =
+        KeyCeremony_Trustee_verify_shares(trustees[i], *all_shares_received);
 
-        {
-            struct KeyCeremony_Trustee_verify_shares_r result =
-                KeyCeremony_Trustee_verify_shares(trustees[i],
-                                                  all_shares_received);
-            if (result.status != KEYCEREMONY_TRUSTEE_SUCCESS)
-                ok = false;
-            else
-                shares_verified = result.message;
-        }
+    if (result.status != KEYCEREMONY_TRUSTEE_SUCCESS)
+        ok = false;
+    else
+        shares_verified = result.message;
 
-        if (ok)
-        {
-            enum KeyCeremony_Coordinator_status status =
-                KeyCeremony_Coordinator_receive_shares_verified(
-                    _keyceremony_coordinator, shares_verified);
-            if (status != KEYCEREMONY_COORDINATOR_SUCCESS)
-                ok = false;
-        }
+    if (ok)
+    {
+        pthread_mutex_lock(&coordinator_lock);
+        enum KeyCeremony_Coordinator_status status =
+            KeyCeremony_Coordinator_receive_shares_verified(
+                _keyceremony_coordinator, shares_verified);
+        pthread_mutex_unlock(&coordinator_lock);
+        if (status != KEYCEREMONY_COORDINATOR_SUCCESS)
+            ok = false;
+    }
 
-        if (shares_verified.bytes != NULL)
-        {
-            free((void *)shares_verified.bytes);
-            shares_verified.bytes = NULL;
-        }
+    if (shares_verified.bytes != NULL)
+    {
+        free((void *)shares_verified.bytes);
+        shares_verified.bytes = NULL;
     }
 
     return ok;
 }
 
+bool verify_shares(struct all_shares_received_message all_shares_received)
+{
+    return run_trustees(verify_trustee_shares, &all_shares_received);
+}
+
 struct joint_public_key publish_joint_key(void)
 {
     struct joint_public_key key = {.bytes = NULL};
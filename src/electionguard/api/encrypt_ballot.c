@@ -5,6 +5,7 @@
 #include <log.h>
 
 #include "api/base_hash.h"
+#include "ballot_index.h"
 #include "directory.h"
 #include "api/filename.h"
 #include "serialize/voting.h"
@@ -176,6 +177,17 @@ bool API_EncryptBallot_soft_delete_file(char *export_path, char *filename)
         }
     }
 
+    // Keep the index with its ballots
+    if (ok)
+    {
+        char *existing_index = Ballot_Index_filename(existing_filename);
+        char *soft_delete_index = Ballot_Index_filename(soft_delete_filename);
+        if (existing_index != NULL && soft_delete_index != NULL)
+            rename(existing_index, soft_delete_index);
+        free(existing_index);
+        free(soft_delete_index);
+    }
+
     if (!ok)
     {
         DEBUG_PRINT(("API_EncryptBallot_soft_delete_file: unable to sofdt delete the file\n\n"));
@@ -221,7 +233,8 @@ bool export_ballot(char *export_path, char *filename, char **output_filename,
         }
 
         int seek_status = fseek(out, 0, SEEK_END);
-        if (seek_status != 0)
+        long offset = ftell(out);
+        if (seek_status != 0 || offset < 0)
         {
             INFO_PRINT(("API_EncryptBallots: export_ballot error seeking file\n"));
             fclose(out);
@@ -236,11 +249,25 @@ bool export_ballot(char *export_path, char *filename, char **output_filename,
             ok = false;
         }
 
+        long end = ftell(out);
+        if (end < 0)
+            ok = false;
+
         if (out != NULL)
         {
-            fclose(out);
+            if (fclose(out) != 0)
+                ok = false;
             out = NULL;
         }
+
+        // Index the ballot so that API_LoadBallots can find it directly.
+        // The ballot is exported either way; without an index it is found
+        // by reading the ballots before it.
+        if (ok && Ballot_Index_append(*output_filename, (uint64_t)offset,
+                                      (uint64_t)end) != BALLOT_INDEX_SUCCESS)
+        {
+            DEBUG_PRINT(("API_EncryptBallots: unable to index the ballot\n"));
+        }
     }
 
     if (!ok)
@@ -1,3 +1,5 @@
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 
 #include <electionguard/api/load_ballots.h>
@@ -5,8 +7,14 @@
 #include <log.h>
 
 #include "api/base_hash.h"
+#include "ballot_index.h"
+#include "ballot_record.h"
 #include "directory.h"
 #include "api/filename.h"
+#include "processors.h"
+
+// Loads of fewer ballots per processor than this aren't split into pages
+#define LOAD_BALLOTS_MIN_PAGE 64
 
 static API_LoadBallots_status initialize_coordinator(uint32_t num_selections);
 static API_LoadBallots_status load_ballots(uint64_t start_index, 
@@ -15,6 +23,14 @@ static API_LoadBallots_status load_ballots(uint64_t start_index,
                     char *import_filepath,
                     char **out_external_identifiers,
                     struct register_ballot_message *out_encrypted_ballots);
+static bool load_indexed_ballots(enum Voting_Coordinator_status *out_status,
+                    FILE *in,
+                    uint64_t start_index,
+                    uint64_t count,
+                    uint32_t num_selections,
+                    char *import_filepath,
+                    char **out_external_identifiers,
+                    struct register_ballot_message *out_encrypted_ballots);
 
 // Global state
 static Voting_Coordinator _load_coordinator = NULL;
@@ -105,7 +121,7 @@ API_LoadBallots_status load_ballots(uint64_t start_index,
                     struct register_ballot_message *out_encrypted_ballots)
 {
     // open the file for read
-    FILE *in = fopen(import_filepath, "r");
+    FILE *in = fopen(import_filepath, "rb");
     if (in == NULL) 
     {
         INFO_PRINT(("API_LoadBallots: load_ballots error accessing file\n"));
@@ -122,15 +138,23 @@ API_LoadBallots_status load_ballots(uint64_t start_index,
 
     enum Voting_Coordinator_status load_result = VOTING_COORDINATOR_SUCCESS;
 
-    load_result = Voting_Coordinator_import_encrypted_ballots(
-        _load_coordinator,
-        start_index,
-        count,
-        num_selections,
-        in,
-        out_external_identifiers,
-        out_encrypted_ballots
-    );
+    // Text files are read from the ballots' offsets when they have an
+    // index, and otherwise from the start
+    if (Ballot_Record_is_binary(in) ||
+        !load_indexed_ballots(&load_result, in, start_index, count,
+                              num_selections, import_filepath,
+                              out_external_identifiers, out_encrypted_ballots))
+    {
+        load_result = Voting_Coordinator_import_encrypted_ballots(
+            _load_coordinator,
+            start_index,
+            count,
+            num_selections,
+            in,
+            out_external_identifiers,
+            out_encrypted_ballots
+        );
+    }
 
     if (in != NULL)
     {
@@ -153,3 +177,211 @@ API_LoadBallots_status load_ballots(uint64_t start_index,
             return API_LOADBALLOTS_UNDEFINED_ERROR;
     }
 }
+
+// A run of consecutive ballots, loaded on its own thread from its own
+// handle on the file
+struct load_ballots_page
+{
+    char *import_filepath;
+    uint64_t start_index;
+    uint64_t offset;
+    uint64_t count;
+    uint32_t num_selections;
+    char **out_external_identifiers;
+    struct register_ballot_message *out_encrypted_ballots;
+    bool started;
+    enum Voting_Coordinator_status status;
+};
+
+static void *load_page(void *arg)
+{
+    struct load_ballots_page *page = arg;
+
+    page->status = VOTING_COORDINATOR_SUCCESS;
+    if (page->count == 0)
+        return NULL;
+
+    FILE *in = fopen(page->import_filepath, "rb");
+    if (in == NULL)
+    {
+        page->status = VOTING_COORDINATOR_IO_ERROR;
+        return NULL;
+    }
+
+    page->status = Voting_Coordinator_import_encrypted_ballots_at(
+        _load_coordinator,
+        page->start_index,
+        page->offset,
+        page->count,
+        page->num_selections,
+        in,
+        page->out_external_identifiers,
+        page->out_encrypted_ballots
+    );
+
+    fclose(in);
+
+    return NULL;
+}
+
+/**
+ * Whether offset in the text ballot file in is where a ballot's line
+ * begins: at the start of the file or just after a newline, with an
+ * external identifier followed by a tab. The lines hold no ballot number,
+ * so this is as far as an offset from the index can be checked without
+ * reading the ballots before it.
+ */
+static bool is_ballot_line(FILE *in, uint64_t offset)
+{
+    if (offset > LONG_MAX)
+        return false;
+
+    long at = (long)offset;
+    bool ok = at == 0 ? fseek(in, 0L, SEEK_SET) == 0
+                      : fseek(in, at - 1, SEEK_SET) == 0 && fgetc(in) == '\n';
+
+    int c = EOF;
+    uint32_t length = 0;
+    while (ok && (c = fgetc(in)) != EOF && c != '\t' && c != '\n' &&
+           length < MAX_EXTERNAL_ID_LENGTH)
+        length++;
+
+    return ok && c == '\t' && length > 0;
+}
+
+/**
+ * Whether the indexed part of the text ballot file in ends at end: within
+ * the file, just after a newline.
+ */
+static bool is_indexed_end(FILE *in, uint64_t end)
+{
+    long size = 0;
+    if (fseek(in, 0L, SEEK_END) != 0 || (size = ftell(in)) < 0 ||
+        end > (uint64_t)size)
+        return false;
+
+    return end == 0 || (fseek(in, (long)end - 1, SEEK_SET) == 0 &&
+                        fgetc(in) == '\n');
+}
+
+/**
+ * Load the ballots through the index of the file open in in, splitting
+ * the indexed ones into pages loaded in parallel. Returns false, having
+ * loaded nothing, when the file has no index, it does not reach
+ * start_index, or it does not match the file, leaving in at its start.
+ */
+bool load_indexed_ballots(enum Voting_Coordinator_status *out_status,
+                    FILE *in,
+                    uint64_t start_index,
+                    uint64_t count,
+                    uint32_t num_selections,
+                    char *import_filepath,
+                    char **out_external_identifiers,
+                    struct register_ballot_message *out_encrypted_ballots)
+{
+    char *index_filepath = Ballot_Index_filename(import_filepath);
+    if (index_filepath == NULL)
+        return false;
+
+    FILE *index = fopen(index_filepath, "rb");
+    free(index_filepath);
+    if (index == NULL)
+        return false;
+
+    // Any ballots past the end of the index were appended without being
+    // indexed, and are read in order from where the indexed ones end
+    uint64_t num_indexed = 0, indexed_end = 0;
+    bool ok = Ballot_Index_count(index, &num_indexed, &indexed_end) ==
+                  BALLOT_INDEX_SUCCESS &&
+              start_index <= num_indexed && is_indexed_end(in, indexed_end);
+
+    uint64_t page_count = 0;
+    if (ok)
+        page_count = count < num_indexed - start_index
+                         ? count
+                         : num_indexed - start_index;
+
+    uint32_t num_pages = Processors_count();
+    if (num_pages > page_count / LOAD_BALLOTS_MIN_PAGE)
+        num_pages = (uint32_t)(page_count / LOAD_BALLOTS_MIN_PAGE);
+    if (num_pages == 0)
+        num_pages = 1;
+
+    struct load_ballots_page *pages = NULL;
+    pthread_t *threads = NULL;
+    if (ok)
+    {
+        pages = malloc(num_pages * sizeof(struct load_ballots_page));
+        threads = malloc(num_pages * sizeof(pthread_t));
+        if (pages == NULL || threads == NULL)
+            ok = false;
+    }
+
+    for (uint32_t k = 0; ok && k < num_pages; k++)
+    {
+        uint64_t begin = page_count * k / num_pages;
+        uint64_t end = page_count * (k + 1) / num_pages;
+        pages[k] = (struct load_ballots_page){
+            .import_filepath = import_filepath,
+            .start_index = start_index + begin,
+            .count = end - begin,
+            .num_selections = num_selections,
+            .out_external_identifiers = out_external_identifiers + begin,
+            .out_encrypted_ballots = out_encrypted_ballots + begin,
+        };
+        if (end > begin &&
+            (Ballot_Index_lookup(index, start_index + begin,
+                                 &pages[k].offset) != BALLOT_INDEX_SUCCESS ||
+             pages[k].offset >= indexed_end ||
+             (k > 0 && pages[k].offset <= pages[k - 1].offset) ||
+             !is_ballot_line(in, pages[k].offset)))
+            ok = false;
+    }
+
+    fclose(index);
+
+    if (!ok)
+        rewind(in);
+
+    if (ok)
+    {
+        // The first page is loaded on this thread, as is any page whose
+        // thread could not be started
+        for (uint32_t k = 1; k < num_pages; k++)
+            pages[k].started =
+                0 == pthread_create(&threads[k], NULL, load_page, &pages[k]);
+
+        for (uint32_t k = 0; k < num_pages; k++)
+            if (!pages[k].started)
+                load_page(&pages[k]);
+
+        for (uint32_t k = 1; k < num_pages; k++)
+            if (pages[k].started)
+                pthread_join(threads[k], NULL);
+
+        *out_status = VOTING_COORDINATOR_SUCCESS;
+        for (uint32_t k = 0; k < num_pages; k++)
+            if (*out_status == VOTING_COORDINATOR_SUCCESS)
+                *out_status = pages[k].status;
+
+        if (*out_status == VOTING_COORDINATOR_SUCCESS && count > page_count)
+        {
+            struct load_ballots_page tail = {
+                .import_filepath = import_filepath,
+                .start_index = start_index + page_count,
+                .offset = indexed_end,
+                .count = count - page_count,
+                .num_selections = num_selections,
+                .out_external_identifiers = out_external_identifiers + page_count,
+                .out_encrypted_ballots = out_encrypted_ballots + page_count,
+            };
+            load_page(&tail);
+            *out_status = tail.status;
+        }
+    }
+
+    free(pages);
+    free(threads);
+
+    return ok;
+}
@@ -8,6 +8,7 @@
 #include "api/base_hash.h"
 #include "api/filename.h"
 #include "directory.h"
+#include "processors.h"
 
 // Initialize
 static bool initialize_coordinator(void);
@@ -150,31 +151,45 @@ bool tally_ballots(char *in_ballots_filename)
 {
     bool ok = true;
 
-    FILE *in = fopen(in_ballots_filename, "r");
+    // Spread the ballots over every processor
+    const uint32_t num_shards = Processors_count();
+
+    // The tally is the same for every trustee, so parse the ballots once
+    // and copy the result to the others
+    Decryption_Trustee tallied = NULL;
 
     for (uint32_t i = 0; i < api_config.num_trustees && ok; i++)
     {
         if (decryption_trustees[i] == NULL)
             continue;
 
-        int seek_status = fseek(in, 0L, SEEK_SET);
-        if (seek_status != 0)
-            ok = false;
-
-        if (ok)
+        enum Decryption_Trustee_status status;
+        if (tallied == NULL)
         {
-            enum Decryption_Trustee_status status =
-                Decryption_Trustee_tally_voting_record(decryption_trustees[i], in);
-
-            if (status != DECRYPTION_TRUSTEE_SUCCESS)
-                ok = false;
+            status = Decryption_Trustee_tally_voting_record_sharded(
+                decryption_trustees[i], in_ballots_filename, num_shards);
+            tallied = decryption_trustees[i];
         }
+        else
+        {
+            status = Decryption_Trustee_copy_tally(decryption_trustees[i],
+                                                   tallied);
+        }
+
+        if (status != DECRYPTION_TRUSTEE_SUCCESS)
+            ok = false;
     }
 
-    if (in != NULL)
+    // No selection's tally exceeds the number of ballots, so size the
+    // discrete log table for larger elections than the default covers
+    if (ok && tallied != NULL)
     {
-        fclose(in);
-        in = NULL;
+        uint64_t num_ballots = Decryption_Trustee_num_ballots(tallied);
+        if (num_ballots > DECRYPTION_COORDINATOR_DEFAULT_MAX_TALLY &&
+            Decryption_Coordinator_build_dlog_table(
+                _decryption_coordinator, num_ballots) !=
+                DECRYPTION_COORDINATOR_SUCCESS)
+            ok = false;
     }
 
     return ok;
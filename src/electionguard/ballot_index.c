@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ballot_index.h"
+
+static const char ballot_index_magic[8] = {'E', 'G', 'B', 'I',
+                                           'N', 'D', 'E', 'X'};
+
+static void put_u64(uint8_t *out, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        out[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_u64(const uint8_t *in)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t)in[i] << (8 * i);
+    return v;
+}
+
+char *Ballot_Index_filename(const char *ballots_filename)
+{
+    size_t length = strlen(ballots_filename);
+    char *result = malloc(length + sizeof(BALLOT_INDEX_SUFFIX));
+    if (result != NULL)
+    {
+        memcpy(result, ballots_filename, length);
+        memcpy(result + length, BALLOT_INDEX_SUFFIX, sizeof(BALLOT_INDEX_SUFFIX));
+    }
+    return result;
+}
+
+// Read the header of the index open in in
+static enum Ballot_Index_status Ballot_Index_read_header(FILE *in,
+                                                         uint64_t *out_end)
+{
+    uint8_t header[BALLOT_INDEX_HEADER_SIZE];
+    if (fseek(in, 0L, SEEK_SET) != 0)
+        return BALLOT_INDEX_IO_ERROR;
+    if (fread(header, 1, sizeof(header), in) != sizeof(header) ||
+        0 != memcmp(header, ballot_index_magic, sizeof(ballot_index_magic)))
+        return BALLOT_INDEX_MALFORMED;
+    *out_end = get_u64(header + 8);
+    return BALLOT_INDEX_SUCCESS;
+}
+
+static enum Ballot_Index_status Ballot_Index_write_header(FILE *out,
+                                                          uint64_t end)
+{
+    uint8_t header[BALLOT_INDEX_HEADER_SIZE];
+    memcpy(header, ballot_index_magic, sizeof(ballot_index_magic));
+    put_u64(header + 8, end);
+    if (fseek(out, 0L, SEEK_SET) != 0 ||
+        fwrite(header, 1, sizeof(header), out) != sizeof(header))
+        return BALLOT_INDEX_IO_ERROR;
+    return BALLOT_INDEX_SUCCESS;
+}
+
+enum Ballot_Index_status Ballot_Index_count(FILE *in, uint64_t *out_count,
+                                            uint64_t *out_end)
+{
+    enum Ballot_Index_status status = Ballot_Index_read_header(in, out_end);
+
+    long end = -1;
+    if (status == BALLOT_INDEX_SUCCESS &&
+        (fseek(in, 0L, SEEK_END) != 0 || (end = ftell(in)) < 0))
+        status = BALLOT_INDEX_IO_ERROR;
+
+    if (status == BALLOT_INDEX_SUCCESS)
+    {
+        uint64_t size = (uint64_t)end - BALLOT_INDEX_HEADER_SIZE;
+        if (size % BALLOT_INDEX_ENTRY_SIZE != 0)
+            status = BALLOT_INDEX_MALFORMED;
+        else
+            *out_count = size / BALLOT_INDEX_ENTRY_SIZE;
+    }
+
+    return status;
+}
+
+enum Ballot_Index_status Ballot_Index_lookup(FILE *in, uint64_t index,
+                                             uint64_t *out_offset)
+{
+    uint64_t count, end;
+    enum Ballot_Index_status status = Ballot_Index_count(in, &count, &end);
+
+    if (status == BALLOT_INDEX_SUCCESS && index >= count)
+        status = BALLOT_INDEX_OUT_OF_RANGE;
+
+    uint8_t entry[BALLOT_INDEX_ENTRY_SIZE];
+    if (status == BALLOT_INDEX_SUCCESS &&
+        (fseek(in, (long)(BALLOT_INDEX_HEADER_SIZE + index * BALLOT_INDEX_ENTRY_SIZE),
+               SEEK_SET) != 0 ||
+         fread(entry, 1, sizeof(entry), in) != sizeof(entry)))
+        status = BALLOT_INDEX_IO_ERROR;
+
+    if (status == BALLOT_INDEX_SUCCESS)
+        *out_offset = get_u64(entry);
+
+    return status;
+}
+
+enum Ballot_Index_status Ballot_Index_append(const char *ballots_filename,
+                                             uint64_t offset, uint64_t end)
+{
+    enum Ballot_Index_status status = BALLOT_INDEX_SUCCESS;
+
+    char *filename = Ballot_Index_filename(ballots_filename);
+    if (filename == NULL)
+        return BALLOT_INDEX_INSUFFICIENT_MEMORY;
+
+    FILE *out = fopen(filename, offset == 0 ? "w+b" : "r+b");
+
+    // Without an index covering the file up to offset, there is nothing
+    // to extend
+    uint64_t indexed_end = 0;
+    if (out == NULL)
+        status = offset == 0 ? BALLOT_INDEX_IO_ERROR : BALLOT_INDEX_MALFORMED;
+    else if (offset == 0)
+        status = Ballot_Index_write_header(out, 0);
+    else
+    {
+        status = Ballot_Index_read_header(out, &indexed_end);
+        if (status == BALLOT_INDEX_SUCCESS && indexed_end != offset)
+            status = BALLOT_INDEX_MALFORMED;
+    }
+
+    uint8_t entry[BALLOT_INDEX_ENTRY_SIZE];
+    put_u64(entry, offset);
+    if (status == BALLOT_INDEX_SUCCESS &&
+        (fseek(out, 0L, SEEK_END) != 0 ||
+         fwrite(entry, 1, sizeof(entry), out) != sizeof(entry)))
+        status = BALLOT_INDEX_IO_ERROR;
+
+    // The header goes last, so that the index only claims the ballot once
+    // it has been recorded
+    if (status == BALLOT_INDEX_SUCCESS)
+        status = Ballot_Index_write_header(out, end);
+
+    if (out != NULL && fclose(out) != 0 && status == BALLOT_INDEX_SUCCESS)
+        status = BALLOT_INDEX_IO_ERROR;
+
+    free(filename);
+
+    return status;
+}
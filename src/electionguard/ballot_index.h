@@ -0,0 +1,51 @@
+#ifndef __BALLOT_INDEX_H__
+#define __BALLOT_INDEX_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+// @design An index kept beside a text ballot file, giving the byte offset
+// at which each ballot's line begins, so that ballot n is found without
+// reading the n before it. It is extended as ballots are appended. Once a
+// ballot is appended without being indexed, the index stops growing but
+// still covers the ballots before it.
+//
+// All integers little endian:
+//     char     magic[8]            "EGBINDEX"
+//     uint64_t end                 size of the part of the file indexed
+//     uint64_t offset[]            one per ballot, in order
+
+#define BALLOT_INDEX_SUFFIX ".index"
+#define BALLOT_INDEX_HEADER_SIZE 16
+#define BALLOT_INDEX_ENTRY_SIZE 8
+
+enum Ballot_Index_status
+{
+    BALLOT_INDEX_SUCCESS,
+    BALLOT_INDEX_INSUFFICIENT_MEMORY,
+    BALLOT_INDEX_IO_ERROR,
+    BALLOT_INDEX_MALFORMED,
+    BALLOT_INDEX_OUT_OF_RANGE,
+};
+
+/* The name of the index of ballots_filename, which the caller frees, or
+ * NULL if there is no memory for it */
+char *Ballot_Index_filename(const char *ballots_filename);
+
+/* Record that a ballot was appended to ballots_filename from offset up to
+ * end. A ballot at offset 0 starts a new index. Any other only extends an
+ * index that covers the file up to offset, since one that did not would
+ * misnumber the ballot. */
+enum Ballot_Index_status Ballot_Index_append(const char *ballots_filename,
+                                             uint64_t offset, uint64_t end);
+
+/* The number of ballots in the index open in in, and the size of the part
+ * of the ballot file they take up, where any ballot after them begins */
+enum Ballot_Index_status Ballot_Index_count(FILE *in, uint64_t *out_count,
+                                            uint64_t *out_end);
+
+/* The offset of ballot number index in the index open in in */
+enum Ballot_Index_status Ballot_Index_lookup(FILE *in, uint64_t index,
+                                             uint64_t *out_offset);
+
+#endif /* __BALLOT_INDEX_H__ */
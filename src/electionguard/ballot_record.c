@@ -0,0 +1,349 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "ballot_record.h"
+
+#if BALLOT_RECORD_NUMBER_SIZE != ENCRYPTION_SLOT_SIZE
+#error "Ballot records hold their numbers in encryption slots"
+#endif
+
+static const char ballot_record_magic[8] = {'E', 'G', 'B', 'A',
+                                            'L', 'L', 'O', 'T'};
+
+static void put_u32(uint8_t *out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *out, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        out[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *in)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t)in[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *in)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t)in[i] << (8 * i);
+    return v;
+}
+
+// Fill in header from the first BALLOT_RECORD_HEADER_SIZE bytes of a file
+static enum Ballot_Record_status
+Ballot_Record_parse_header(const uint8_t *in, struct ballot_record_header *header)
+{
+    if (0 != memcmp(in, ballot_record_magic, sizeof(ballot_record_magic)) ||
+        get_u32(in + 8) != BALLOT_RECORD_VERSION)
+        return BALLOT_RECORD_MALFORMED;
+
+    header->num_selections = get_u32(in + 12);
+    header->external_id_width = get_u32(in + 16);
+    header->num_records = get_u64(in + 24);
+
+    if (header->num_selections > MAX_SELECTIONS ||
+        header->external_id_width % 8 != 0 ||
+        header->external_id_width > BALLOT_RECORD_EXTERNAL_ID_WIDTH)
+        return BALLOT_RECORD_MALFORMED;
+
+    return BALLOT_RECORD_SUCCESS;
+}
+
+bool Ballot_Record_is_binary(FILE *in)
+{
+    char magic[sizeof(ballot_record_magic)];
+    long position = ftell(in);
+    bool binary = position >= 0 &&
+                  fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+                  0 == memcmp(magic, ballot_record_magic, sizeof(magic));
+
+    if (position >= 0)
+        fseek(in, position, SEEK_SET);
+
+    return binary;
+}
+
+size_t Ballot_Record_record_size(const struct ballot_record_header *header)
+{
+    return 16 + header->external_id_width +
+           (size_t)header->num_selections * 2 * BALLOT_RECORD_NUMBER_SIZE;
+}
+
+enum Ballot_Record_status
+Ballot_Record_write_header(FILE *out, const struct ballot_record_header *header)
+{
+    uint8_t bytes[BALLOT_RECORD_HEADER_SIZE] = {0};
+    memcpy(bytes, ballot_record_magic, sizeof(ballot_record_magic));
+    put_u32(bytes + 8, BALLOT_RECORD_VERSION);
+    put_u32(bytes + 12, header->num_selections);
+    put_u32(bytes + 16, header->external_id_width);
+    put_u64(bytes + 24, header->num_records);
+
+    if (fwrite(bytes, 1, sizeof(bytes), out) != sizeof(bytes))
+        return BALLOT_RECORD_IO_ERROR;
+
+    return BALLOT_RECORD_SUCCESS;
+}
+
+enum Ballot_Record_status
+Ballot_Record_read_header(FILE *in, struct ballot_record_header *header)
+{
+    uint8_t bytes[BALLOT_RECORD_HEADER_SIZE];
+    if (fread(bytes, 1, sizeof(bytes), in) != sizeof(bytes))
+        return BALLOT_RECORD_IO_ERROR;
+
+    return Ballot_Record_parse_header(bytes, header);
+}
+
+// Write z as BALLOT_RECORD_NUMBER_SIZE bytes, least significant first
+static bool Ballot_Record_write_number(FILE *out, const mpz_t z)
+{
+    uint8_t bytes[BALLOT_RECORD_NUMBER_SIZE] = {0};
+    if (mpz_sgn(z) < 0 ||
+        mpz_sizeinbase(z, 2) > 8 * BALLOT_RECORD_NUMBER_SIZE)
+        return false;
+
+    mpz_export(bytes, NULL, -1, 8, -1, 0, z);
+    return fwrite(bytes, 1, sizeof(bytes), out) == sizeof(bytes);
+}
+
+enum Ballot_Record_status
+Ballot_Record_write(FILE *out, const struct ballot_record_header *header,
+                    uint64_t id, bool cast, const char *external_id,
+                    const struct encryption_rep *selections)
+{
+    enum Ballot_Record_status status = BALLOT_RECORD_SUCCESS;
+
+    size_t external_id_length = external_id == NULL ? 0 : strlen(external_id);
+    if (external_id_length > header->external_id_width)
+        external_id_length = header->external_id_width;
+
+    uint8_t fixed[16];
+    put_u64(fixed, id);
+    put_u32(fixed + 8, cast);
+    put_u32(fixed + 12, (uint32_t)external_id_length);
+    if (fwrite(fixed, 1, sizeof(fixed), out) != sizeof(fixed))
+        status = BALLOT_RECORD_IO_ERROR;
+
+    // The identifier, padded with zeroes to the width of the file
+    for (uint32_t i = 0;
+         i < header->external_id_width && status == BALLOT_RECORD_SUCCESS; i++)
+    {
+        int c = i < external_id_length ? (uint8_t)external_id[i] : 0;
+        if (fputc(c, out) == EOF)
+            status = BALLOT_RECORD_IO_ERROR;
+    }
+
+    for (uint32_t i = 0;
+         i < header->num_selections && status == BALLOT_RECORD_SUCCESS; i++)
+    {
+        if (!Ballot_Record_write_number(out, selections[i].nonce_encoding) ||
+            !Ballot_Record_write_number(out, selections[i].message_encoding))
+            status = BALLOT_RECORD_IO_ERROR;
+    }
+
+    return status;
+}
+
+// Map the file underlying in, setting record->data and record->size
+static bool Ballot_Record_map(struct ballot_record *record, FILE *in)
+{
+#ifdef _WIN32
+    HANDLE file = (HANDLE)_get_osfhandle(_fileno(in));
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) ||
+        size.QuadPart == 0)
+        return false;
+
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+        return false;
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    record->mapping = mapping;
+    record->data = data;
+    record->size = (size_t)size.QuadPart;
+#else
+    struct stat stats;
+    if (fstat(fileno(in), &stats) != 0 || stats.st_size <= 0)
+        return false;
+
+    void *data = mmap(NULL, (size_t)stats.st_size, PROT_READ, MAP_PRIVATE,
+                      fileno(in), 0);
+    if (data == MAP_FAILED)
+        return false;
+
+    record->mapping = data;
+    record->data = data;
+    record->size = (size_t)stats.st_size;
+#endif
+    record->mapped = true;
+    return true;
+}
+
+// Read the whole of in into memory, for when it cannot be mapped
+static enum Ballot_Record_status Ballot_Record_load(struct ballot_record *record,
+                                                    FILE *in)
+{
+    long size = -1;
+    if (fseek(in, 0L, SEEK_END) == 0)
+        size = ftell(in);
+    if (size <= 0 || fseek(in, 0L, SEEK_SET) != 0)
+        return BALLOT_RECORD_IO_ERROR;
+
+    uint8_t *data = malloc((size_t)size);
+    if (data == NULL)
+        return BALLOT_RECORD_INSUFFICIENT_MEMORY;
+
+    if (fread(data, 1, (size_t)size, in) != (size_t)size)
+    {
+        free(data);
+        return BALLOT_RECORD_IO_ERROR;
+    }
+
+    record->mapped = false;
+    record->mapping = data;
+    record->data = data;
+    record->size = (size_t)size;
+    return BALLOT_RECORD_SUCCESS;
+}
+
+enum Ballot_Record_status Ballot_Record_open(struct ballot_record *record,
+                                             FILE *in)
+{
+    enum Ballot_Record_status status = BALLOT_RECORD_SUCCESS;
+    record->data = NULL;
+    record->mapping = NULL;
+
+    if (!Ballot_Record_map(record, in))
+        status = Ballot_Record_load(record, in);
+
+    if (status == BALLOT_RECORD_SUCCESS && record->size < BALLOT_RECORD_HEADER_SIZE)
+        status = BALLOT_RECORD_MALFORMED;
+
+    if (status == BALLOT_RECORD_SUCCESS)
+        status = Ballot_Record_parse_header(record->data, &record->header);
+
+    // Every record the header claims must be there
+    if (status == BALLOT_RECORD_SUCCESS)
+    {
+        record->record_size = Ballot_Record_record_size(&record->header);
+        size_t available = (record->size - BALLOT_RECORD_HEADER_SIZE) /
+                           record->record_size;
+        if (record->header.num_records > available)
+            status = BALLOT_RECORD_MALFORMED;
+    }
+
+    if (status != BALLOT_RECORD_SUCCESS && record->data != NULL)
+        Ballot_Record_close(record);
+
+    return status;
+}
+
+void Ballot_Record_close(struct ballot_record *record)
+{
+    if (record->mapped)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(record->data);
+        CloseHandle(record->mapping);
+#else
+        munmap(record->mapping, record->size);
+#endif
+    }
+    else
+        free(record->mapping);
+
+    record->data = NULL;
+    record->mapping = NULL;
+}
+
+static const uint8_t *Ballot_Record_at(const struct ballot_record *record,
+                                       uint64_t index)
+{
+    return record->data + BALLOT_RECORD_HEADER_SIZE +
+           (size_t)index * record->record_size;
+}
+
+uint64_t Ballot_Record_id(const struct ballot_record *record, uint64_t index)
+{
+    return get_u64(Ballot_Record_at(record, index));
+}
+
+bool Ballot_Record_cast(const struct ballot_record *record, uint64_t index)
+{
+    return get_u32(Ballot_Record_at(record, index) + 8) != 0;
+}
+
+void Ballot_Record_external_id(const struct ballot_record *record,
+                               uint64_t index, char *out_external_id)
+{
+    const uint8_t *at = Ballot_Record_at(record, index);
+    uint32_t length = get_u32(at + 12);
+    if (length > record->header.external_id_width)
+        length = record->header.external_id_width;
+
+    memcpy(out_external_id, at + 16, length);
+    out_external_id[length] = '\0';
+}
+
+void Ballot_Record_selections(const struct ballot_record *record,
+                              uint64_t index,
+                              struct encryption_rep *out_selections)
+{
+    const uint8_t *at = Ballot_Record_at(record, index) + 16 +
+                        record->header.external_id_width;
+
+    for (uint32_t i = 0; i < record->header.num_selections; i++)
+    {
+        mpz_import(out_selections[i].nonce_encoding,
+                   BALLOT_RECORD_NUMBER_SIZE / 8, -1, 8, -1, 0, at);
+        at += BALLOT_RECORD_NUMBER_SIZE;
+        mpz_import(out_selections[i].message_encoding,
+                   BALLOT_RECORD_NUMBER_SIZE / 8, -1, 8, -1, 0, at);
+        at += BALLOT_RECORD_NUMBER_SIZE;
+    }
+}
+
+void Ballot_Record_selection_slots(const struct ballot_record *record,
+                                   uint64_t index,
+                                   struct encryption_slots *out_slots)
+{
+    // A record holds its numbers in the order and size of the slots, so
+    // this only puts the bytes of each limb in host order
+    const uint8_t *at = Ballot_Record_at(record, index) + 16 +
+                        record->header.external_id_width;
+    size_t num_limbs = (size_t)record->header.num_selections * 2 *
+                       ENCRYPTION_SLOT_LIMBS;
+
+    for (size_t i = 0; i < num_limbs; i++, at += sizeof(mp_limb_t))
+    {
+        mp_limb_t limb = 0;
+        for (size_t j = 0; j < sizeof(mp_limb_t); j++)
+            limb |= (mp_limb_t)at[j] << (8 * j);
+        out_slots->limbs[i] = limb;
+    }
+}
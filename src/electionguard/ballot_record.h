@@ -0,0 +1,111 @@
+#ifndef __BALLOT_RECORD_H__
+#define __BALLOT_RECORD_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "crypto_reps.h"
+
+// @design A binary alternative to the text ballot files, which spend
+// most of their size and most of the time it takes to read them on hex
+// digits. A file is a header followed by fixed size records, so record i
+// is found without reading the ones before it, and the numbers in it are
+// imported straight out of a memory map of the file.
+//
+// Header, all integers little endian:
+//     char     magic[8]            "EGBALLOT"
+//     uint32_t version             BALLOT_RECORD_VERSION
+//     uint32_t num_selections
+//     uint32_t external_id_width   multiple of 8, may be 0
+//     uint32_t reserved            0
+//     uint64_t num_records
+// Record:
+//     uint64_t id
+//     uint32_t cast
+//     uint32_t external_id_length
+//     char     external_id[external_id_width]
+//     per selection, nonce encoding then message encoding, each
+//     BALLOT_RECORD_NUMBER_SIZE bytes, least significant first
+
+#define BALLOT_RECORD_VERSION 1
+#define BALLOT_RECORD_HEADER_SIZE 32
+#define BALLOT_RECORD_NUMBER_SIZE 512
+
+/* The external id width for files that keep the external identifiers of
+ * their ballots: room for any identifier, rounded up to a multiple of 8 */
+#define BALLOT_RECORD_EXTERNAL_ID_WIDTH                                        \
+    ((MAX_EXTERNAL_ID_LENGTH + 1 + 7) / 8 * 8)
+
+enum Ballot_Record_status
+{
+    BALLOT_RECORD_SUCCESS,
+    BALLOT_RECORD_INSUFFICIENT_MEMORY,
+    BALLOT_RECORD_IO_ERROR,
+    BALLOT_RECORD_MALFORMED,
+};
+
+struct ballot_record_header
+{
+    uint32_t num_selections;
+    uint32_t external_id_width;
+    uint64_t num_records;
+};
+
+/* A read-only view of a whole binary ballot file */
+struct ballot_record
+{
+    struct ballot_record_header header;
+    size_t record_size;
+    const uint8_t *data;
+    size_t size;
+    // How data was obtained, to release it the same way
+    bool mapped;
+    void *mapping;
+};
+
+/* Whether in is positioned at the start of a binary ballot file. Leaves the
+ * position of in unchanged. */
+bool Ballot_Record_is_binary(FILE *in);
+
+/* The size of a record in a file with the given header */
+size_t Ballot_Record_record_size(const struct ballot_record_header *header);
+
+/* Write a header at the current position of out */
+enum Ballot_Record_status
+Ballot_Record_write_header(FILE *out, const struct ballot_record_header *header);
+
+/* Read a header from the current position of in */
+enum Ballot_Record_status
+Ballot_Record_read_header(FILE *in, struct ballot_record_header *header);
+
+/* Write a record at the current position of out. external_id may be NULL,
+ * and is truncated to the width of the file. */
+enum Ballot_Record_status
+Ballot_Record_write(FILE *out, const struct ballot_record_header *header,
+                    uint64_t id, bool cast, const char *external_id,
+                    const struct encryption_rep *selections);
+
+/* Map all of the file underlying in, which must be a binary ballot file,
+ * falling back to reading it into memory where it cannot be mapped. */
+enum Ballot_Record_status Ballot_Record_open(struct ballot_record *record,
+                                             FILE *in);
+void Ballot_Record_close(struct ballot_record *record);
+
+/* The fields of record number index, which must be below num_records.
+ * out_external_id must have room for external_id_width + 1 characters. */
+uint64_t Ballot_Record_id(const struct ballot_record *record, uint64_t index);
+bool Ballot_Record_cast(const struct ballot_record *record, uint64_t index);
+void Ballot_Record_external_id(const struct ballot_record *record,
+                               uint64_t index, char *out_external_id);
+void Ballot_Record_selections(const struct ballot_record *record,
+                              uint64_t index,
+                              struct encryption_rep *out_selections);
+/* The selections of record number index, copied into out_slots, which
+ * must have room for num_selections selections */
+void Ballot_Record_selection_slots(const struct ballot_record *record,
+                                   uint64_t index,
+                                   struct encryption_slots *out_slots);
+
+#endif /* __BALLOT_RECORD_H__ */
@@ -1,3 +1,4 @@
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -87,6 +88,31 @@ mpz_t q;
 mpz_t generator;
 mpz_t bignum_one;
 
+// Montgomery arithmetic mod p with R = 2^4096: p as limbs, -p^-1 mod the
+// limb base, and R^2 mod p for converting into Montgomery form.
+#if GMP_NAIL_BITS != 0
+#error "Montgomery multiplication mod p assumes GMP without nail bits"
+#endif
+static mp_limb_t mont_p_modulus[MONT_P_LIMBS];
+static mp_limb_t mont_p_inverse;
+static mpz_t mont_p_r2;
+
+static void mont_p_new(void)
+{
+    mpz_export(mont_p_modulus, NULL, -1, sizeof(mp_limb_t), 0, 0, p);
+
+    // Newton's iteration doubles the number of correct low bits each step,
+    // starting from the 1 bit that is right for any odd modulus.
+    mp_limb_t inverse = 1;
+    for (int bits = 1; bits < GMP_NUMB_BITS; bits *= 2)
+        inverse *= 2 - mont_p_modulus[0] * inverse;
+    mont_p_inverse = -inverse;
+
+    mpz_init(mont_p_r2);
+    mpz_setbit(mont_p_r2, 2 * 4096);
+    mpz_mod(mont_p_r2, mont_p_r2, p);
+}
+
 void Crypto_parameters_new()
 {
     mpz_init(p);
@@ -99,6 +125,8 @@ void Crypto_parameters_new()
     mpz_import(p, 64, 1, 8, 0, 0, p_array);
     // In the v0.8 spec this is much smaller -- a 256-bit number instead.
     mpz_import(q, 4, 1, 8, 0, 0, q_array);
+
+    mont_p_new();
 }
 
 void Crypto_parameters_free()
@@ -107,6 +135,98 @@ void Crypto_parameters_free()
     mpz_clear(q);
     mpz_clear(generator);
     mpz_clear(bignum_one);
+    mpz_clear(mont_p_r2);
+
+    bignum_scratch_free();
+}
+
+// Room for the product of two numbers mod p, and then some
+#define SCRATCH_BITS (2 * 4096 + 2 * GMP_NUMB_BITS)
+#define SCRATCH_POOL_SIZE 16
+
+// values[0, num_free) have room for SCRATCH_BITS and are free to lend.
+// The rest hold whatever was given in exchange, which may not be allocated.
+struct scratch_pool
+{
+    uint32_t num_free;
+    mpz_t values[SCRATCH_POOL_SIZE];
+};
+
+static pthread_key_t scratch_key;
+static bool scratch_key_ok;
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+
+static void scratch_pool_free(void *arg)
+{
+    struct scratch_pool *pool = arg;
+    for (uint32_t i = 0; i < SCRATCH_POOL_SIZE; i++)
+        mpz_clear(pool->values[i]);
+    free(pool);
+}
+
+static void scratch_key_new(void)
+{
+    scratch_key_ok = 0 == pthread_key_create(&scratch_key, scratch_pool_free);
+}
+
+// The calling thread's pool, or NULL if it cannot have one
+static struct scratch_pool *scratch_pool_get(void)
+{
+    pthread_once(&scratch_once, scratch_key_new);
+    if (!scratch_key_ok)
+        return NULL;
+
+    struct scratch_pool *pool = pthread_getspecific(scratch_key);
+    if (pool == NULL)
+    {
+        pool = malloc(sizeof(struct scratch_pool));
+        if (pool == NULL)
+            return NULL;
+        pool->num_free = 0;
+        for (uint32_t i = 0; i < SCRATCH_POOL_SIZE; i++)
+            mpz_init(pool->values[i]);
+        if (0 != pthread_setspecific(scratch_key, pool))
+        {
+            scratch_pool_free(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void bignum_scratch_init(mpz_t x)
+{
+    struct scratch_pool *pool = scratch_pool_get();
+    if (pool != NULL && pool->num_free > 0)
+    {
+        mpz_init(x);
+        mpz_swap(x, pool->values[--pool->num_free]);
+        mpz_set_ui(x, 0);
+    }
+    else
+        mpz_init2(x, SCRATCH_BITS);
+}
+
+void bignum_scratch_clear(mpz_t x)
+{
+    struct scratch_pool *pool = scratch_pool_get();
+    if (pool != NULL && pool->num_free < SCRATCH_POOL_SIZE)
+        mpz_swap(x, pool->values[pool->num_free++]);
+    mpz_clear(x);
+}
+
+void bignum_scratch_free(void)
+{
+    pthread_once(&scratch_once, scratch_key_new);
+    if (!scratch_key_ok)
+        return;
+
+    struct scratch_pool *pool = pthread_getspecific(scratch_key);
+    if (pool != NULL)
+    {
+        pthread_setspecific(scratch_key, NULL);
+        scratch_pool_free(pool);
+    }
 }
 
 void print_base16(const mpz_t z)
@@ -155,34 +275,519 @@ void mul_mod_p(mpz_t res, const mpz_t a, const mpz_t b)
     mpz_mod(res, res, p);
 }
 
-//This function can only decrypt numbers below 5,000,000.
-//if provided a larger number it will return false and a nonsense result
-//if this is too slow for larger elections it can be replaced with a precomputed
-//lookup table to achieve log n performance relative to the value being decrypted
-bool log_generator_mod_p(mpz_t result, mpz_t a)
+// The limbs of a < 2^4096, padded with zeros into scratch when a is short
+static const mp_limb_t *mont_p_operand(const mpz_t a, mp_limb_t *scratch)
 {
-    mpz_t max_decryption;
-    mpz_init(max_decryption);
-    mpz_set_ui(max_decryption, 5000000);
+    size_t size = mpz_size(a);
+    if (size == MONT_P_LIMBS)
+        return mpz_limbs_read(a);
+
+    memset(scratch, 0, sizeof(mp_limb_t) * MONT_P_LIMBS);
+    if (size != 0)
+        memcpy(scratch, mpz_limbs_read(a), sizeof(mp_limb_t) * size);
+    return scratch;
+}
 
-    mpz_set_ui(result, 0);
-    mpz_t powmod;
-    mpz_init(powmod);
-    mpz_set_ui(powmod, 1);
-    while (!(0 == mpz_cmp(powmod, a)))
+// t / R mod p for t < pR, left in the top half of t. Each step clears the
+// lowest limb of t by adding a multiple of p; the carries out of those
+// additions are collected and added to the top half in one go.
+static mp_limb_t *mont_p_reduce_n(mp_limb_t *t)
+{
+    mp_limb_t carries[MONT_P_LIMBS];
+    for (size_t i = 0; i < MONT_P_LIMBS; i++)
     {
-        mpz_add_ui(result, result, 1);
-        mul_mod_p(powmod, powmod, generator);
-#ifdef DEBUG_PRINT
-        print_base16(powmod);
-#endif
-    if(mpz_cmp(a,max_decryption) == 0){
-        return false;
+        carries[i] = mpn_addmul_1(t + i, mont_p_modulus, MONT_P_LIMBS,
+                                  t[i] * mont_p_inverse);
+    }
+
+    mp_limb_t *r = t + MONT_P_LIMBS;
+    mp_limb_t overflow = mpn_add_n(r, r, carries, MONT_P_LIMBS);
+    // timing
+    if (overflow || mpn_cmp(r, mont_p_modulus, MONT_P_LIMBS) >= 0)
+        mpn_sub_n(r, r, mont_p_modulus, MONT_P_LIMBS);
+
+    return r;
+}
+
+// res = t / R mod p for t < pR, destroying t
+static void mont_p_reduce(mpz_t res, mp_limb_t *t)
+{
+    mpn_copyi(mpz_limbs_write(res, MONT_P_LIMBS), mont_p_reduce_n(t),
+              MONT_P_LIMBS);
+    mpz_limbs_finish(res, MONT_P_LIMBS);
+}
+
+void mont_mul_p(mpz_t res, const mpz_t a, const mpz_t b)
+{
+    mp_limb_t a_scratch[MONT_P_LIMBS], b_scratch[MONT_P_LIMBS];
+    mp_limb_t t[2 * MONT_P_LIMBS];
+
+    const mp_limb_t *a_limbs = mont_p_operand(a, a_scratch);
+    if (a == b)
+        mpn_sqr(t, a_limbs, MONT_P_LIMBS);
+    else
+        mpn_mul_n(t, a_limbs, mont_p_operand(b, b_scratch), MONT_P_LIMBS);
+
+    mont_p_reduce(res, t);
+}
+
+void mont_mul_p_n(mp_limb_t *res, const mp_limb_t *a, const mp_limb_t *b)
+{
+    mp_limb_t t[2 * MONT_P_LIMBS];
+    mpn_mul_n(t, a, b, MONT_P_LIMBS);
+    mpn_copyi(res, mont_p_reduce_n(t), MONT_P_LIMBS);
+}
+
+void to_mont_p(mpz_t res, const mpz_t a) { mont_mul_p(res, a, mont_p_r2); }
+
+void from_mont_p(mpz_t res, const mpz_t a)
+{
+    mp_limb_t t[2 * MONT_P_LIMBS] = {0};
+    mpn_copyi(t, mont_p_operand(a, t), MONT_P_LIMBS);
+    mont_p_reduce(res, t);
+}
+
+void mont_scale_p(mpz_t res, const mpz_t a, uint64_t num_reductions)
+{
+    mpz_t r_power;
+    mpz_init(r_power);
+    import_uint64_ts(r_power, &num_reductions, 1);
+    mpz_mul_2exp(r_power, r_power, 12);
+
+    mpz_t two;
+    mpz_init_set_ui(two, 2);
+    pow_mod_p(r_power, two, r_power);
+    mul_mod_p(res, a, r_power);
+
+    mpz_clear(two);
+    mpz_clear(r_power);
+}
+
+// Each window covers FIXED_BASE_WINDOW_BITS bits of the exponent. Row i of
+// the table holds base^(d * 2^(FIXED_BASE_WINDOW_BITS * i)) for every digit
+// d, so an exponentiation is one multiplication per non-zero window.
+#define FIXED_BASE_WINDOW_BITS 5
+#define FIXED_BASE_DIGITS (1 << FIXED_BASE_WINDOW_BITS)
+
+bignum_status fixed_base_table_new(struct fixed_base_table *table,
+                                   const mpz_t base)
+{
+    const uint32_t exp_bits = mpz_sizeinbase(q, 2);
+    table->num_windows =
+        (exp_bits + FIXED_BASE_WINDOW_BITS - 1) / FIXED_BASE_WINDOW_BITS;
+    table->powers =
+        malloc(table->num_windows * FIXED_BASE_DIGITS * sizeof(mpz_t));
+    if (table->powers == NULL)
+    {
+        table->num_windows = 0;
+        return BIGNUM_INSUFFICIENT_MEMORY;
+    }
+
+    // The powers are kept in Montgomery form
+    mpz_t window_base;
+    mpz_init(window_base);
+    mpz_mod(window_base, base, p);
+    to_mont_p(window_base, window_base);
+
+    for (uint32_t i = 0; i < table->num_windows; i++)
+    {
+        mpz_t *row = table->powers + i * FIXED_BASE_DIGITS;
+        mpz_init(row[0]);
+        to_mont_p(row[0], bignum_one);
+        for (uint32_t d = 1; d < FIXED_BASE_DIGITS; d++)
+        {
+            mpz_init(row[d]);
+            mont_mul_p(row[d], row[d - 1], window_base);
+        }
+        // window_base^(2^FIXED_BASE_WINDOW_BITS) is the base of the next row
+        mont_mul_p(window_base, row[FIXED_BASE_DIGITS - 1], window_base);
+    }
+
+    mpz_clear(window_base);
+    return BIGNUM_SUCCESS;
+}
+
+void fixed_base_table_free(struct fixed_base_table *table)
+{
+    for (uint32_t i = 0; i < table->num_windows * FIXED_BASE_DIGITS; i++)
+    {
+        mpz_clear(table->powers[i]);
+    }
+    free(table->powers);
+    table->powers = NULL;
+    table->num_windows = 0;
+}
+
+void pow_mod_p_fixed(mpz_t res, const struct fixed_base_table *table,
+                     const mpz_t exp)
+{
+    // The base has order q, so reducing first gives the same result as
+    // pow_mod_p and bounds the exponent to the windows in the table.
+    mpz_t reduced;
+    bignum_scratch_init(reduced);
+    mod_q(reduced, exp);
+
+    bool started = false;
+    for (uint32_t i = 0; i < table->num_windows; i++)
+    {
+        uint32_t digit = 0;
+        for (uint32_t b = 0; b < FIXED_BASE_WINDOW_BITS; b++)
+        {
+            if (mpz_tstbit(reduced, i * FIXED_BASE_WINDOW_BITS + b))
+                digit |= 1u << b;
+        }
+        // timing
+        if (digit == 0)
+            continue;
+
+        const mpz_t *power = &table->powers[i * FIXED_BASE_DIGITS + digit];
+        if (started)
+            mont_mul_p(res, res, *power);
+        else
+            mpz_set(res, *power);
+        started = true;
+    }
+
+    if (started)
+        from_mont_p(res, res);
+    else
+        mpz_set_ui(res, 1);
+
+    bignum_scratch_clear(reduced);
+}
+
+// Straus' method: every base gets a small table of its first
+// 2^MULTI_POW_WINDOW_BITS powers, and the exponents are scanned together
+// from the top, so the squarings are paid once instead of once per base.
+#define MULTI_POW_WINDOW_BITS 4
+#define MULTI_POW_DIGITS (1 << MULTI_POW_WINDOW_BITS)
+
+void multi_pow_mod_p(mpz_t res, mpz_srcptr const *bases, mpz_srcptr const *exps,
+                     uint32_t n)
+{
+    mpz_t *powers = malloc(n * MULTI_POW_DIGITS * sizeof(mpz_t));
+    if (powers == NULL)
+    {
+        // No room for the tables, so do the exponentiations one at a time
+        mpz_t term;
+        mpz_init(term);
+        mpz_set_ui(res, 1);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            pow_mod_p(term, bases[i], exps[i]);
+            mul_mod_p(res, res, term);
+        }
+        mpz_clear(term);
+        return;
     }
+
+    size_t max_bits = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        // The powers are kept in Montgomery form; row[0] is never used
+        mpz_t *row = powers + i * MULTI_POW_DIGITS;
+        mpz_init(row[0]);
+        mpz_init(row[1]);
+        mpz_mod(row[1], bases[i], p);
+        to_mont_p(row[1], row[1]);
+        for (uint32_t d = 2; d < MULTI_POW_DIGITS; d++)
+        {
+            mpz_init(row[d]);
+            mont_mul_p(row[d], row[d - 1], row[1]);
+        }
+
+        size_t bits = mpz_sizeinbase(exps[i], 2);
+        if (bits > max_bits)
+            max_bits = bits;
     }
+
+    const size_t num_windows =
+        (max_bits + MULTI_POW_WINDOW_BITS - 1) / MULTI_POW_WINDOW_BITS;
+
+    bool started = false;
+    for (size_t w = num_windows; w-- > 0;)
+    {
+        if (started)
+        {
+            for (uint32_t s = 0; s < MULTI_POW_WINDOW_BITS; s++)
+                mont_mul_p(res, res, res);
+        }
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint32_t digit = 0;
+            for (uint32_t b = 0; b < MULTI_POW_WINDOW_BITS; b++)
+            {
+                if (mpz_tstbit(exps[i], w * MULTI_POW_WINDOW_BITS + b))
+                    digit |= 1u << b;
+            }
+            // timing
+            if (digit == 0)
+                continue;
+
+            if (started)
+                mont_mul_p(res, res, powers[i * MULTI_POW_DIGITS + digit]);
+            else
+                mpz_set(res, powers[i * MULTI_POW_DIGITS + digit]);
+            started = true;
+        }
+    }
+
+    if (started)
+        from_mont_p(res, res);
+    else
+        mpz_set_ui(res, 1);
+
+    for (uint32_t i = 0; i < n * MULTI_POW_DIGITS; i++)
+    {
+        mpz_clear(powers[i]);
+    }
+    free(powers);
+}
+
+// The low 64 bits of x, used as the key of a baby step
+static uint64_t dlog_fingerprint(const mpz_t x)
+{
+    uint64_t fingerprint = 0;
+    for (size_t i = 0; i * GMP_NUMB_BITS < 64; i++)
+        fingerprint |= (uint64_t)mpz_getlimbn(x, i) << (i * GMP_NUMB_BITS);
+    return fingerprint;
+}
+
+static int dlog_entry_compare(const void *l, const void *r)
+{
+    uint64_t a = ((const struct dlog_entry *)l)->fingerprint;
+    uint64_t b = ((const struct dlog_entry *)r)->fingerprint;
+    return (a > b) - (a < b);
+}
+
+// The giant step g^-m, and the fingerprint of g^m that a stored table must
+// match to have been built for this generator
+static void dlog_giant_step(mpz_t giant_step, uint64_t *check,
+                            uint64_t num_baby_steps)
+{
+    mpz_t m;
+    mpz_init(m);
+    mpz_import(m, 1, 1, sizeof(num_baby_steps), 0, 0, &num_baby_steps);
+    pow_mod_p(giant_step, generator, m);
+    *check = dlog_fingerprint(giant_step);
+    mpz_invert(giant_step, giant_step, p);
+    mpz_clear(m);
+}
+
+// The number of baby steps m for logs up to max_log, so that m giant steps
+// of m cover them
+static uint64_t dlog_num_baby_steps(uint64_t max_log)
+{
+    mpz_t bound;
+    mpz_init(bound);
+    mpz_import(bound, 1, 1, sizeof(max_log), 0, 0, &max_log);
+    mpz_sqrt(bound, bound);
+    uint64_t m = 0;
+    mpz_export(&m, NULL, 1, sizeof(m), 0, 0, bound);
+    mpz_clear(bound);
+    return m + 1;
+}
+
+bignum_status dlog_table_new(struct dlog_table *table, uint64_t max_log)
+{
+    bignum_status status = BIGNUM_SUCCESS;
+
+    uint64_t m = dlog_num_baby_steps(max_log);
+
+    table->max_log = max_log;
+    table->num_baby_steps = m;
+    table->baby_steps = malloc(m * sizeof(struct dlog_entry));
+    mpz_init(table->giant_step);
+    if (table->baby_steps == NULL)
+        status = BIGNUM_INSUFFICIENT_MEMORY;
+
+    if (status == BIGNUM_SUCCESS)
+    {
+        // g^j for j in [0, m)
+        mpz_t power;
+        mpz_init_set_ui(power, 1);
+        for (uint64_t j = 0; j < m; j++)
+        {
+            table->baby_steps[j] = (struct dlog_entry){
+                .fingerprint = dlog_fingerprint(power),
+                .exponent = j,
+            };
+            mul_mod_p(power, power, generator);
+        }
+        mpz_clear(power);
+
+        qsort(table->baby_steps, m, sizeof(struct dlog_entry),
+              dlog_entry_compare);
+
+        uint64_t check;
+        dlog_giant_step(table->giant_step, &check, m);
+    }
+    else
+        dlog_table_free(table);
+
+    return status;
+}
+
+void dlog_table_free(struct dlog_table *table)
+{
+    free(table->baby_steps);
+    table->baby_steps = NULL;
+    mpz_clear(table->giant_step);
+}
+
+// Tables are stored as a magic string, then max_log, the number of baby
+// steps, the fingerprint of g^m and the sorted baby steps, all as little
+// endian 64 bit integers.
+static const char dlog_table_magic[8] = {'E', 'G', 'D', 'L', 'O', 'G', '0', '1'};
+
+static bool dlog_write_u64(FILE *out, uint64_t v)
+{
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++)
+        bytes[i] = (uint8_t)(v >> (8 * i));
+    return fwrite(bytes, 1, 8, out) == 8;
+}
+
+static bool dlog_read_u64(FILE *in, uint64_t *v)
+{
+    uint8_t bytes[8];
+    if (fread(bytes, 1, 8, in) != 8)
+        return false;
+    *v = 0;
+    for (int i = 0; i < 8; i++)
+        *v |= (uint64_t)bytes[i] << (8 * i);
     return true;
 }
 
+bignum_status dlog_table_fwrite(const struct dlog_table *table, FILE *out)
+{
+    bool ok = fwrite(dlog_table_magic, 1, 8, out) == 8;
+
+    mpz_t power;
+    mpz_init(power);
+    mpz_invert(power, table->giant_step, p);
+    ok = ok && dlog_write_u64(out, table->max_log);
+    ok = ok && dlog_write_u64(out, table->num_baby_steps);
+    ok = ok && dlog_write_u64(out, dlog_fingerprint(power));
+    mpz_clear(power);
+
+    for (uint64_t j = 0; ok && j < table->num_baby_steps; j++)
+    {
+        ok = dlog_write_u64(out, table->baby_steps[j].fingerprint) &&
+             dlog_write_u64(out, table->baby_steps[j].exponent);
+    }
+
+    return ok ? BIGNUM_SUCCESS : BIGNUM_IO_ERROR;
+}
+
+bignum_status dlog_table_fread(struct dlog_table *table, FILE *in)
+{
+    bignum_status status = BIGNUM_SUCCESS;
+    uint64_t stored_check = 0;
+
+    char magic[8];
+    table->baby_steps = NULL;
+    mpz_init(table->giant_step);
+    if (fread(magic, 1, 8, in) != 8 ||
+        memcmp(magic, dlog_table_magic, 8) != 0 ||
+        !dlog_read_u64(in, &table->max_log) ||
+        !dlog_read_u64(in, &table->num_baby_steps) ||
+        !dlog_read_u64(in, &stored_check))
+        status = BIGNUM_IO_ERROR;
+
+    // Any other number of baby steps would make a failed search take too
+    // many giant steps
+    if (status == BIGNUM_SUCCESS &&
+        table->num_baby_steps != dlog_num_baby_steps(table->max_log))
+        status = BIGNUM_IO_ERROR;
+
+    if (status == BIGNUM_SUCCESS)
+    {
+        table->baby_steps =
+            malloc(table->num_baby_steps * sizeof(struct dlog_entry));
+        if (table->baby_steps == NULL)
+            status = BIGNUM_INSUFFICIENT_MEMORY;
+    }
+
+    for (uint64_t j = 0;
+         status == BIGNUM_SUCCESS && j < table->num_baby_steps; j++)
+    {
+        struct dlog_entry *entry = &table->baby_steps[j];
+        if (!dlog_read_u64(in, &entry->fingerprint) ||
+            !dlog_read_u64(in, &entry->exponent) ||
+            entry->exponent >= table->num_baby_steps ||
+            (j > 0 && entry->fingerprint < entry[-1].fingerprint))
+            status = BIGNUM_IO_ERROR;
+    }
+
+    // Reject tables built for another generator
+    if (status == BIGNUM_SUCCESS)
+    {
+        uint64_t check;
+        dlog_giant_step(table->giant_step, &check, table->num_baby_steps);
+        if (check != stored_check)
+            status = BIGNUM_IO_ERROR;
+    }
+
+    if (status != BIGNUM_SUCCESS)
+        dlog_table_free(table);
+
+    return status;
+}
+
+bool log_generator_mod_p(mpz_t result, const mpz_t a,
+                         const struct dlog_table *table)
+{
+    bool found = false;
+    const uint64_t m = table->num_baby_steps;
+
+    mpz_t target, giant, candidate, check;
+    mpz_init(target);
+    mpz_init(giant);
+    mpz_init(candidate);
+    mpz_init(check);
+    mpz_mod(target, a, p);
+    mpz_set(giant, target);
+
+    // giant = a * g^(-i*m), which is some g^j in the table iff a = g^(i*m + j)
+    for (uint64_t i = 0; !found && i <= table->max_log / m; i++)
+    {
+        struct dlog_entry key = {.fingerprint = dlog_fingerprint(giant)};
+        struct dlog_entry *entry =
+            bsearch(&key, table->baby_steps, m, sizeof(struct dlog_entry),
+                    dlog_entry_compare);
+
+        // Fingerprints can collide, so check every match
+        while (entry != NULL && entry > table->baby_steps &&
+               entry[-1].fingerprint == key.fingerprint)
+            entry--;
+        for (; !found && entry != NULL && entry < table->baby_steps + m &&
+               entry->fingerprint == key.fingerprint;
+             entry++)
+        {
+            if (entry->exponent > table->max_log - i * m)
+                continue;
+            uint64_t log = i * m + entry->exponent;
+            mpz_import(candidate, 1, 1, sizeof(log), 0, 0, &log);
+            pow_mod_p(check, generator, candidate);
+            if (0 == mpz_cmp(check, target))
+            {
+                found = true;
+                mpz_set(result, candidate);
+            }
+        }
+
+        mul_mod_p(giant, giant, table->giant_step);
+    }
+
+    mpz_clear(target);
+    mpz_clear(giant);
+    mpz_clear(candidate);
+    mpz_clear(check);
+    return found;
+}
+
 void mod_q(mpz_t res, const mpz_t a) { mpz_mod(res, a, q); }
 
 void add_mod_q(mpz_t res, const mpz_t l, const mpz_t r)
@@ -206,23 +811,23 @@ void mul_mod_q(mpz_t res, const mpz_t l, const mpz_t r)
 void div_mod_p(mpz_t res, const mpz_t num, const mpz_t den)
 {
     mpz_t inverse;
-    mpz_init(inverse);
+    bignum_scratch_init(inverse);
 
     mpz_invert(inverse, den, p);
     mul_mod_p(res, num, inverse);
 
-    mpz_clear(inverse);
+    bignum_scratch_clear(inverse);
 }
 
 void div_mod_q(mpz_t res, const mpz_t num, const mpz_t den)
 {
     mpz_t inverse;
-    mpz_init(inverse);
+    bignum_scratch_init(inverse);
 
     mpz_invert(inverse, den, q);
     mul_mod_q(res, num, inverse);
 
-    mpz_clear(inverse);
+    bignum_scratch_clear(inverse);
 }
 
 // Export a mpz to a number of 64 bit ints. If the last int isn't filled out
@@ -14,7 +14,84 @@ typedef enum bignum_status
 void pow_mod_p(mpz_t res, const mpz_t base, const mpz_t exp);
 void mul_mod_p(mpz_t res, const mpz_t a, const mpz_t b);
 void div_mod_p(mpz_t res, const mpz_t num, const mpz_t den);
-bool log_generator_mod_p(mpz_t result, mpz_t a);
+
+/* Montgomery multiplication mod p, which replaces the division of mul_mod_p
+ * with a cheaper reduction. x is in Montgomery form as x * 2^4096 mod p, and
+ * the Montgomery product of two numbers in that form stays in it, so a chain
+ * of multiplications converts in and out once rather than dividing at each
+ * step. mont_mul_p needs a < p and b < 2^4096. */
+#define MONT_P_LIMBS (4096 / GMP_NUMB_BITS)
+void mont_mul_p(mpz_t res, const mpz_t a, const mpz_t b); // a * b / 2^4096
+/* mont_mul_p on numbers held as MONT_P_LIMBS limbs, least significant
+ * first, with no mpz_t to allocate. res may be a or b. */
+void mont_mul_p_n(mp_limb_t *res, const mp_limb_t *a, const mp_limb_t *b);
+void to_mont_p(mpz_t res, const mpz_t a);
+void from_mont_p(mpz_t res, const mpz_t a);
+/* res = a * 2^(4096 * num_reductions) mod p, which undoes num_reductions
+ * Montgomery products of numbers that were never put in Montgomery form. */
+void mont_scale_p(mpz_t res, const mpz_t a, uint64_t num_reductions);
+
+/* Baby steps for finding discrete logarithms of powers of the generator
+ * with baby-step giant-step. A table for logs up to max_log holds about
+ * sqrt(max_log) baby steps, and a search takes as many multiplications. */
+struct dlog_entry
+{
+    uint64_t fingerprint;
+    uint64_t exponent;
+};
+
+struct dlog_table
+{
+    uint64_t max_log;
+    uint64_t num_baby_steps;
+    // g^exponent for each exponent below num_baby_steps, by fingerprint
+    struct dlog_entry *baby_steps;
+    // g^-num_baby_steps
+    mpz_t giant_step;
+};
+
+bignum_status dlog_table_new(struct dlog_table *table, uint64_t max_log);
+void dlog_table_free(struct dlog_table *table);
+bignum_status dlog_table_fwrite(const struct dlog_table *table, FILE *out);
+/* Read a table written by dlog_table_fwrite, rejecting it with
+ * BIGNUM_IO_ERROR if it is malformed or was built for another generator. */
+bignum_status dlog_table_fread(struct dlog_table *table, FILE *in);
+
+/* Find result <= table->max_log with g^result = a, returning false if
+ * there is none. */
+bool log_generator_mod_p(mpz_t result, const mpz_t a,
+                         const struct dlog_table *table);
+
+/* A table of precomputed powers of a fixed base, so that raising that base
+ * to an exponent needs no squarings. Exponents are reduced mod q, so a table
+ * must only be built for bases in the order-q subgroup (the generator, and
+ * public keys derived from it). Once built, a table is read-only. */
+struct fixed_base_table
+{
+    uint32_t num_windows;
+    mpz_t *powers;
+};
+
+bignum_status fixed_base_table_new(struct fixed_base_table *table,
+                                   const mpz_t base);
+void fixed_base_table_free(struct fixed_base_table *table);
+void pow_mod_p_fixed(mpz_t res, const struct fixed_base_table *table,
+                     const mpz_t exp);
+
+/* res = bases[0]^exps[0] * ... * bases[n-1]^exps[n-1] mod p, sharing one
+ * chain of squarings between all n exponentiations. */
+void multi_pow_mod_p(mpz_t res, mpz_srcptr const *bases, mpz_srcptr const *exps,
+                     uint32_t n);
+
+/* Stand-ins for mpz_init and mpz_clear for temporaries, which take their
+ * limbs from a pool kept for each thread and give them back, so that once
+ * the pool has filled they do not allocate. A temporary starts at 0 with
+ * room for the product of two numbers mod p, and must be cleared on the
+ * thread that initialized it. bignum_scratch_free empties the calling
+ * thread's pool, as does the thread exiting. */
+void bignum_scratch_init(mpz_t x);
+void bignum_scratch_clear(mpz_t x);
+void bignum_scratch_free(void);
 
 void mod_q(mpz_t res, const mpz_t a);
 void add_mod_q(mpz_t res, const mpz_t l, const mpz_t r);
@@ -26,34 +26,33 @@ void Crypto_hash_reduce(struct hash *out, raw_hash bytes)
 
 // NOTE: Currently no error handling is possible for this function call. 
 // Consider changing the function signature in the future
-void Crypto_hash_update_bignum_q(SHA2_CTX *context, mpz_t num)
+// Hash num as num_words 64-bit words, most significant first and each least
+// significant byte first, padded with zeros, with no allocation
+static void Crypto_hash_update_bignum_words(SHA2_CTX *context,
+                                            const mpz_t num, size_t num_words)
 {
-    uint64_t *buf = NULL;
-    bignum_status export_status = export_to_256(num, &buf);
-    if (export_status == BIGNUM_SUCCESS)
-    {
-        if (buf != NULL)
-        {
-            SHA256Update(context, (uint8_t *)buf, 256 / 8);
-            free(buf);
-        }
-        else
-        {
-            DEBUG_PRINT(("\nCrypto_hash_update_bignum_q: tmp is null - FAILED!\n"));
-        }
-    }
-    else
+    uint8_t bytes[4096 / 8] = {0};
+    size_t count = mpz_sgn(num) == 0 ? 0 : (mpz_sizeinbase(num, 2) + 63) / 64;
+
+    if (mpz_sgn(num) < 0 || count > num_words)
     {
         // TODO: return something
-        DEBUG_PRINT(("\nCrypto_hash_update_bignum_q: export_to_256 - FAILED!\n"));
+        DEBUG_PRINT(("\nCrypto_hash_update_bignum_words: too large - FAILED!\n"));
+        return;
     }
+
+    mpz_export(bytes + 8 * (num_words - count), NULL, 1, 8, -1, 0, num);
+    SHA256Update(context, bytes, 8 * num_words);
+}
+
+void Crypto_hash_update_bignum_q(SHA2_CTX *context, const mpz_t num)
+{
+    Crypto_hash_update_bignum_words(context, num, 256 / 64);
 }
 
-void Crypto_hash_update_bignum_p(SHA2_CTX *context, mpz_t num)
+void Crypto_hash_update_bignum_p(SHA2_CTX *context, const mpz_t num)
 {
-    uint8_t *serialized_buffer = Serialize_reserve_write_bignum(num);
-    SHA256Update(context, serialized_buffer, 4096 / 8);
-    free(serialized_buffer);
+    Crypto_hash_update_bignum_words(context, num, 4096 / 64);
 }
 
 bool Crypto_public_key_equal(struct public_key const *key1,
@@ -144,7 +143,7 @@ struct Crypto_gen_keypair_r Crypto_gen_keypair(uint32_t num_coefficients,
         if (CRYPTO_SUCCESS == result.status)
         {
             result.status = Crypto_RandomSource_status_convert(
-                RandomSource_uniform_bignum_o(
+                RandomSource_uniform_bignum_o_q(
                     result.private_key.coefficients[i], source));
             if (CRYPTO_SUCCESS != result.status)
             {
@@ -388,16 +387,23 @@ bool Crypto_check_validity_share_against_public_keys(
     mpz_t origin;
     mpz_init(origin);
 
-    mpz_t exp;
-    mpz_init(exp);
+    // prod_i C_i^((my_index+1)^i), as a single multi-exponentiation
+    mpz_t exps[MAX_TRUSTEES];
+    mpz_srcptr exp_ptrs[MAX_TRUSTEES];
+    mpz_srcptr commitments[MAX_TRUSTEES];
 
     for (uint32_t i = 0; i < num_trusties; i++){
-        mpz_set_ui(exp, my_index+1);
-        mpz_pow_ui(exp, exp, i);
-        pow_mod_p(exp, pubKeys->coef_commitments[i],exp);
-        mul_mod_p(out_1, out_1, exp);
+        mpz_init(exps[i]);
+        mpz_ui_pow_ui(exps[i], my_index + 1, i);
+        exp_ptrs[i] = exps[i];
+        commitments[i] = pubKeys->coef_commitments[i];
     }
 
+    multi_pow_mod_p(out_1, commitments, exp_ptrs, num_trusties);
+
+    for (uint32_t i = 0; i < num_trusties; i++)
+        mpz_clear(exps[i]);
+
     RSA_Decrypt(origin, share->encrypted, privateKey);
 
     pow_mod_p(out_2, generator, origin);
@@ -481,6 +487,131 @@ void Crypto_generate_joint_public_key(struct joint_public_key_rep *dst,
     }
 }
 
+enum Crypto_status Crypto_fixed_bases_new(struct Crypto_fixed_bases *dst,
+                                          const mpz_t public_key)
+{
+    enum Crypto_status status = CRYPTO_SUCCESS;
+
+    if (fixed_base_table_new(&dst->generator, generator) != BIGNUM_SUCCESS)
+        status = CRYPTO_INSUFFICIENT_MEMORY;
+
+    if (CRYPTO_SUCCESS == status &&
+        fixed_base_table_new(&dst->public_key, public_key) != BIGNUM_SUCCESS)
+    {
+        fixed_base_table_free(&dst->generator);
+        status = CRYPTO_INSUFFICIENT_MEMORY;
+    }
+
+    return status;
+}
+
+void Crypto_fixed_bases_free(struct Crypto_fixed_bases *dst)
+{
+    fixed_base_table_free(&dst->generator);
+    fixed_base_table_free(&dst->public_key);
+}
+
+// g^exp, from the precomputed table when the caller has one
+static void Crypto_pow_generator(mpz_t res, const mpz_t exp,
+                                 const struct Crypto_fixed_bases *bases)
+{
+    if (bases != NULL)
+        pow_mod_p_fixed(res, &bases->generator, exp);
+    else
+        pow_mod_p(res, generator, exp);
+}
+
+// K^exp, from the precomputed table when the caller has one
+static void Crypto_pow_public_key(mpz_t res, const mpz_t public_key,
+                                  const mpz_t exp,
+                                  const struct Crypto_fixed_bases *bases)
+{
+    if (bases != NULL)
+        pow_mod_p_fixed(res, &bases->public_key, exp);
+    else
+        pow_mod_p(res, public_key, exp);
+}
+
+// A temporary encryption, with numbers from the scratch pool
+static void Crypto_encryption_rep_scratch_new(struct encryption_rep *dst)
+{
+    bignum_scratch_init(dst->nonce_encoding);
+    bignum_scratch_init(dst->message_encoding);
+}
+
+static void Crypto_encryption_rep_scratch_free(struct encryption_rep *dst)
+{
+    bignum_scratch_clear(dst->nonce_encoding);
+    bignum_scratch_clear(dst->message_encoding);
+}
+
+// Check g^g_exp * K^k_exp == commitment * base^base_exp, where a NULL g_exp
+// or k_exp leaves that factor out. With precomputed tables the powers of g
+// and K are cheap, so only base^base_exp is a full exponentiation. Without
+// them the equation is rearranged to
+//     commitment == g^g_exp * K^k_exp * (base^-1)^base_exp
+// and evaluated as one multi-exponentiation.
+static bool Crypto_check_exp_equation(const mpz_t commitment,
+                                      const mpz_t g_exp, const mpz_t k_exp,
+                                      const mpz_t public_key, const mpz_t base,
+                                      const mpz_t base_exp,
+                                      const struct Crypto_fixed_bases *bases)
+{
+    bool result;
+    mpz_t lhs, rhs;
+    bignum_scratch_init(lhs);
+    bignum_scratch_init(rhs);
+
+    if (bases != NULL)
+    {
+        mpz_set_ui(lhs, 1);
+        if (g_exp != NULL)
+        {
+            pow_mod_p_fixed(rhs, &bases->generator, g_exp);
+            mul_mod_p(lhs, lhs, rhs);
+        }
+        if (k_exp != NULL)
+        {
+            pow_mod_p_fixed(rhs, &bases->public_key, k_exp);
+            mul_mod_p(lhs, lhs, rhs);
+        }
+        pow_mod_p(rhs, base, base_exp);
+        mul_mod_p(rhs, commitment, rhs);
+        result = (0 == mpz_cmp(lhs, rhs));
+    }
+    else if (0 == mpz_invert(rhs, base, p))
+    {
+        // base is 0 mod p, so the right hand side is 0 and cannot match
+        result = false;
+    }
+    else
+    {
+        mpz_srcptr factors[3];
+        mpz_srcptr exps[3];
+        uint32_t n = 0;
+        if (g_exp != NULL)
+        {
+            factors[n] = generator;
+            exps[n++] = g_exp;
+        }
+        if (k_exp != NULL)
+        {
+            factors[n] = public_key;
+            exps[n++] = k_exp;
+        }
+        factors[n] = rhs;
+        exps[n++] = base_exp;
+
+        multi_pow_mod_p(lhs, factors, exps, n);
+        mpz_mod(rhs, commitment, p);
+        result = (0 == mpz_cmp(lhs, rhs));
+    }
+
+    bignum_scratch_clear(lhs);
+    bignum_scratch_clear(rhs);
+    return result;
+}
+
 void Crypto_cp_proof_commit(struct encryption_rep *commitment_out,
                             struct encryption_rep encryption, mpz_t u)
 {
@@ -512,11 +643,12 @@ void Crypto_cp_proof_challenge(struct hash *challenge_out,
 
 void Crypto_generate_decryption_cp_proof(
     struct cp_proof_rep *result, mpz_t secret_key, mpz_t partial_decryption,
-    struct encryption_rep aggregate_encryption, struct hash base_hash)
+    struct encryption_rep aggregate_encryption, struct hash base_hash,
+    const struct Crypto_fixed_bases *bases)
 {
     //The random value for the proof, we reuse letters from the spec document
     mpz_t u;
-    mpz_init(u);
+    bignum_scratch_init(u);
 
     RandomSource source;
     struct RandomSource_new_r source_r = RandomSource_new();
@@ -525,7 +657,7 @@ void Crypto_generate_decryption_cp_proof(
     RandomSource_uniform_bignum_o_q(u, source);
 
     // commitment a in the documents
-    pow_mod_p(result->commitment.nonce_encoding, generator, u);
+    Crypto_pow_generator(result->commitment.nonce_encoding, u, bases);
     // commitment b in the documents
     pow_mod_p(result->commitment.message_encoding,
               aggregate_encryption.nonce_encoding, u);
@@ -551,41 +683,45 @@ void Crypto_generate_decryption_cp_proof(
     mul_mod_q(result->response, result->challenge.digest, secret_key);
     add_mod_q(result->response, u, result->response);
 
-    mpz_clear(u);
+    bignum_scratch_clear(u);
     RandomSource_free(source);
 }
 
 bool Crypto_check_decryption_cp_proof(
     struct cp_proof_rep proof, mpz_t public_key, mpz_t partial_decryption,
-    struct encryption_rep aggregate_encryption, struct hash base_hash)
+    struct encryption_rep aggregate_encryption, struct hash base_hash,
+    const struct Crypto_fixed_bases *bases)
 {
 
     bool result = true;
-    mpz_t gv, av, akc, bbc;
-    mpz_init(gv);
-    mpz_init(akc);
-    mpz_init(av);
-    mpz_init(bbc);
-
-    pow_mod_p(gv, generator, proof.response);
-    pow_mod_p(akc, public_key, proof.challenge.digest);
-    mul_mod_p(akc, proof.commitment.nonce_encoding, akc);
-
-    result &= (0 == mpz_cmp(gv, akc));
-
-    //A^v
-    pow_mod_p(av, aggregate_encryption.nonce_encoding, proof.response);
-    //M^c
-    pow_mod_p(bbc, partial_decryption, proof.challenge.digest);
-    //b*Beta^c
-    mul_mod_p(bbc, proof.commitment.message_encoding, bbc);
-
-    result &= (0 == mpz_cmp(av, bbc));
-
-    mpz_clear(gv);
-    mpz_clear(akc);
-    mpz_clear(av);
-    mpz_clear(bbc);
+
+    // g^v = a * K^c
+    result &= Crypto_check_exp_equation(proof.commitment.nonce_encoding,
+                                        proof.response, NULL, public_key,
+                                        public_key, proof.challenge.digest,
+                                        bases);
+
+    // A^v = b * M^c, checked as b = A^v * (M^-1)^c
+    mpz_t av, m_inverse;
+    bignum_scratch_init(av);
+    bignum_scratch_init(m_inverse);
+
+    if (0 == mpz_invert(m_inverse, partial_decryption, p))
+        result = false;
+
+    if (result)
+    {
+        mpz_srcptr factors[2] = {aggregate_encryption.nonce_encoding,
+                                 m_inverse};
+        mpz_srcptr exps[2] = {proof.response, proof.challenge.digest};
+        multi_pow_mod_p(av, factors, exps, 2);
+        mpz_mod(m_inverse, proof.commitment.message_encoding, p);
+
+        result &= (0 == mpz_cmp(av, m_inverse));
+    }
+
+    bignum_scratch_clear(av);
+    bignum_scratch_clear(m_inverse);
     return result;
 }
 
@@ -594,6 +730,7 @@ bool Crypto_check_decryption_cp_proof(
 _Bool Crypto_check_aggregate_cp_proof(struct cp_proof_rep proof,
                                       struct encryption_rep encryption,
                                       struct hash base_hash, mpz_t public_key,
+                                      const struct Crypto_fixed_bases *bases,
                                       uint32_t l_int)
 {
 
@@ -603,7 +740,7 @@ _Bool Crypto_check_aggregate_cp_proof(struct cp_proof_rep proof,
     SHA2_CTX context;
 
     struct hash my_C;
-    mpz_init(my_C.digest);
+    bignum_scratch_init(my_C.digest);
     //Serialize the base hash
     uint8_t *base_serial = Serialize_reserve_write_hash(base_hash);
 
@@ -618,122 +755,204 @@ _Bool Crypto_check_aggregate_cp_proof(struct cp_proof_rep proof,
 
     result &= (0 == mpz_cmp(my_C.digest, proof.challenge.digest));
 
-    mpz_t gv, aac, glc, glckv, bbc;
-    mpz_init(gv);
-    mpz_init(aac);
-    mpz_init(glc);
-    mpz_init(glckv);
-    mpz_init(bbc);
-
-    pow_mod_p(gv, generator, proof.response);
-    pow_mod_p(aac, encryption.nonce_encoding, my_C.digest);
-    mul_mod_p(aac, proof.commitment.nonce_encoding, aac);
-
-    result &= (0 == mpz_cmp(gv, aac));
+    // g^v = a * A^C
+    result &= Crypto_check_exp_equation(proof.commitment.nonce_encoding,
+                                        proof.response, NULL, public_key,
+                                        encryption.nonce_encoding, my_C.digest,
+                                        bases);
 
     // number of selections set to L
     mpz_t L;
-    mpz_init(L);
+    bignum_scratch_init(L);
     mpz_set_ui(L, l_int);
     mul_mod_q(L, L, my_C.digest);
 
-    // g^(LC)
-    pow_mod_p(glc, generator, L);
-    // K^v
-    pow_mod_p(glckv, public_key, proof.response);
-    // g^LC * K^v
-    mul_mod_p(glckv, glc, glckv);
-
-    //Beta^c
-    pow_mod_p(bbc, encryption.message_encoding, my_C.digest);
-    //b*Beta^c
-    mul_mod_p(bbc, proof.commitment.message_encoding, bbc);
-
-    result &= (0 == mpz_cmp(glckv, bbc));
-
-    mpz_clear(gv);
-    mpz_clear(aac);
-    mpz_clear(glc);
-    mpz_clear(glckv);
-    mpz_clear(bbc);
-    mpz_clear(my_C.digest);
+    // g^LC * K^v = b * B^C
+    result &= Crypto_check_exp_equation(proof.commitment.message_encoding, L,
+                                        proof.response, public_key,
+                                        encryption.message_encoding,
+                                        my_C.digest, bases);
+
+    bignum_scratch_clear(L);
+    bignum_scratch_clear(my_C.digest);
     return result;
 }
 
+// Complete an aggregate proof whose commitment (g^u, K^u) is in result
+static void Crypto_aggregate_cp_proof_respond(struct cp_proof_rep *result,
+                                              mpz_t nonce,
+                                              struct encryption_rep encryption,
+                                              struct hash base_hash,
+                                              const mpz_t u)
+{
+    mpz_init(result->challenge.digest);
+    Crypto_cp_proof_challenge(&result->challenge, encryption,
+                              result->commitment, base_hash);
+
+    // CR in the doc
+    mul_mod_q(result->response, result->challenge.digest, nonce);
+    add_mod_q(result->response, u, result->response);
+}
+
 void Crypto_generate_aggregate_cp_proof(struct cp_proof_rep *result,
                                         RandomSource source, mpz_t nonce,
                                         struct encryption_rep encryption,
-                                        struct hash base_hash, mpz_t public_key)
+                                        struct hash base_hash, mpz_t public_key,
+                                        const struct Crypto_fixed_bases *bases)
 {
     //The random value for the proof, we reuse letters from the spec document
     mpz_t u;
-    mpz_init(u);
+    bignum_scratch_init(u);
 
     RandomSource_uniform_bignum_o_q(u, source);
 
     // commitment a in the documents
-    pow_mod_p(result->commitment.nonce_encoding, generator, u);
+    Crypto_pow_generator(result->commitment.nonce_encoding, u, bases);
     // commitment b in the documents
-    pow_mod_p(result->commitment.message_encoding, public_key, u);
+    Crypto_pow_public_key(result->commitment.message_encoding, public_key, u,
+                          bases);
 
-    mpz_init(result->challenge.digest);
-    Crypto_cp_proof_challenge(&result->challenge, encryption,
-                              result->commitment, base_hash);
+    Crypto_aggregate_cp_proof_respond(result, nonce, encryption, base_hash, u);
 
-    // CR in the doc
-    mul_mod_q(result->response, result->challenge.digest, nonce);
-    add_mod_q(result->response, u, result->response);
+    bignum_scratch_clear(u);
+}
 
-    mpz_clear(u);
+void Crypto_generate_aggregate_cp_proof_precomputed(
+    struct cp_proof_rep *result, mpz_t nonce, struct encryption_rep encryption,
+    struct hash base_hash, const struct Crypto_encryption_precomputation *pre)
+{
+    // Any fresh g^u, K^u will do for the commitment, such as the pad of an
+    // encryption that is not otherwise used
+    Crypto_encryption_rep_copy(&result->commitment,
+                               (struct encryption_rep *)&pre->pad);
+    Crypto_aggregate_cp_proof_respond(result, nonce, encryption, base_hash,
+                                      pre->nonce);
+}
+
+// The challenge of a disjunctive proof: the hash of the base hash, the
+// encryption and the commitments, in the order they appear in the proof
+static void Crypto_dis_proof_challenge(struct hash *out, struct hash base_hash,
+                                       const struct encryption_rep *encryption,
+                                       const struct encryption_rep *commitment0,
+                                       const struct encryption_rep *commitment1)
+{
+    SHA2_CTX context;
+
+    //Serialize the base hash
+    uint8_t *base_serial = Serialize_reserve_write_hash(base_hash);
+
+    SHA256Init(&context);
+    SHA256Update(&context, base_serial, SHA256_DIGEST_LENGTH);
+    Crypto_hash_update_bignum_p(&context, encryption->nonce_encoding);
+    Crypto_hash_update_bignum_p(&context, encryption->message_encoding);
+    Crypto_hash_update_bignum_p(&context, commitment0->nonce_encoding);
+    Crypto_hash_update_bignum_p(&context, commitment0->message_encoding);
+    Crypto_hash_update_bignum_p(&context, commitment1->nonce_encoding);
+    Crypto_hash_update_bignum_p(&context, commitment1->message_encoding);
+    Crypto_hash_final(out, &context);
+
+    free(base_serial);
+}
+
+// Hash the commitments of a disjunctive proof into its challenge, then
+// answer the real half and fill in result
+static void Crypto_dis_proof_respond(struct dis_proof_rep *result,
+                                     struct hash base_hash, bool selected,
+                                     struct encryption_rep encryption,
+                                     const mpz_t nonce, const mpz_t u,
+                                     struct encryption_rep *real_commitment,
+                                     struct encryption_rep *fake_commitment,
+                                     const mpz_t fake_challenge,
+                                     const mpz_t fake_response)
+{
+    mpz_t real_challenge;
+    mpz_t real_response;
+    bignum_scratch_init(real_challenge);
+    bignum_scratch_init(real_response);
+
+    //Generate the main challenge. The real half of the proof comes second
+    //when the selection is made.
+    if (selected)
+        Crypto_dis_proof_challenge(&result->challenge, base_hash, &encryption,
+                                   fake_commitment, real_commitment);
+    else
+        Crypto_dis_proof_challenge(&result->challenge, base_hash, &encryption,
+                                   real_commitment, fake_commitment);
+
+    sub_mod_q(real_challenge, result->challenge.digest, fake_challenge);
+
+    mul_mod_q(real_response, real_challenge, nonce);
+    add_mod_q(real_response, u, real_response);
+
+    if (selected)
+    {
+        Crypto_encryption_rep_copy(&result->commitment0, fake_commitment);
+        Crypto_encryption_rep_copy(&result->commitment1, real_commitment);
+        mpz_set(result->challenge0, fake_challenge);
+        mpz_set(result->challenge1, real_challenge);
+        mpz_set(result->response0, fake_response);
+        mpz_set(result->response1, real_response);
+    }
+    else
+    {
+        Crypto_encryption_rep_copy(&result->commitment0, real_commitment);
+        Crypto_encryption_rep_copy(&result->commitment1, fake_commitment);
+        mpz_set(result->challenge0, real_challenge);
+        mpz_set(result->challenge1, fake_challenge);
+        mpz_set(result->response0, real_response);
+        mpz_set(result->response1, fake_response);
+    }
+
+    bignum_scratch_clear(real_challenge);
+    bignum_scratch_clear(real_response);
 }
 
 void Crypto_generate_dis_proof(struct dis_proof_rep *result,
                                RandomSource source, struct hash base_hash,
                                bool selected, mpz_t public_key,
+                               const struct Crypto_fixed_bases *bases,
                                struct encryption_rep encryption, mpz_t nonce)
 {
     mpz_t fake_challenge;
-    mpz_t real_challenge;
     mpz_t fake_response;
-    mpz_t real_response;
     mpz_t u;
     mpz_t scratch;
 
     struct encryption_rep real_commitment;
     struct encryption_rep fake_commitment;
 
-    Crypto_encryption_rep_new(&real_commitment);
-    Crypto_encryption_rep_new(&fake_commitment);
+    Crypto_encryption_rep_scratch_new(&real_commitment);
+    Crypto_encryption_rep_scratch_new(&fake_commitment);
 
-    mpz_init(fake_challenge);
-    mpz_init(fake_response);
-    mpz_init(real_challenge);
-    mpz_init(real_response);
-    mpz_init(scratch);
+    bignum_scratch_init(fake_challenge);
+    bignum_scratch_init(fake_response);
+    bignum_scratch_init(scratch);
 
-    mpz_init(u);
+    bignum_scratch_init(u);
 
     // Generate the randomness and the fake proof
     RandomSource_uniform_bignum_o_q(u, source);
-    RandomSource_uniform_bignum_o(fake_challenge, source);
-    RandomSource_uniform_bignum_o(fake_response, source);
+    RandomSource_uniform_bignum_o_q(fake_challenge, source);
+    RandomSource_uniform_bignum_o_q(fake_response, source);
 
     //Generate the real commitments
-    pow_mod_p(real_commitment.nonce_encoding, generator, u);
-    pow_mod_p(real_commitment.message_encoding, public_key, u);
+    Crypto_pow_generator(real_commitment.nonce_encoding, u, bases);
+    Crypto_pow_public_key(real_commitment.message_encoding, public_key, u,
+                          bases);
 
     //Generate the fake commitments
-    pow_mod_p(scratch, generator, fake_response);
+    Crypto_pow_generator(scratch, fake_response, bases);
     pow_mod_p(fake_commitment.nonce_encoding, encryption.nonce_encoding,
               fake_challenge);
     div_mod_p(fake_commitment.nonce_encoding, scratch,
               fake_commitment.nonce_encoding);
 
-    pow_mod_p(scratch, public_key, fake_response);
+    Crypto_pow_public_key(scratch, public_key, fake_response, bases);
     if (!selected)
     {
         //using message encoding temporarily
-        pow_mod_p(fake_commitment.message_encoding, generator, fake_challenge);
+        Crypto_pow_generator(fake_commitment.message_encoding, fake_challenge,
+                             bases);
         mul_mod_p(scratch, scratch, fake_commitment.message_encoding);
     }
 
@@ -742,147 +961,497 @@ void Crypto_generate_dis_proof(struct dis_proof_rep *result,
     div_mod_p(fake_commitment.message_encoding, scratch,
               fake_commitment.message_encoding);
 
-    //Generate the main challenge
-    SHA2_CTX context;
+    Crypto_dis_proof_respond(result, base_hash, selected, encryption, nonce, u,
+                             &real_commitment, &fake_commitment,
+                             fake_challenge, fake_response);
 
-    //Serialize the base hash
-    uint8_t *base_serial = Serialize_reserve_write_hash(base_hash);
+    Crypto_encryption_rep_scratch_free(&real_commitment);
+    Crypto_encryption_rep_scratch_free(&fake_commitment);
 
-    SHA256Init(&context);
-    SHA256Update(&context, base_serial, SHA256_DIGEST_LENGTH);
-    Crypto_hash_update_bignum_p(&context, encryption.nonce_encoding);
-    Crypto_hash_update_bignum_p(&context, encryption.message_encoding);
+    bignum_scratch_clear(fake_challenge);
+    bignum_scratch_clear(fake_response);
+    bignum_scratch_clear(u);
+    bignum_scratch_clear(scratch);
 
-    if (selected)
-    {
-        Crypto_hash_update_bignum_p(&context, fake_commitment.nonce_encoding);
-        Crypto_hash_update_bignum_p(&context, fake_commitment.message_encoding);
-        Crypto_hash_update_bignum_p(&context, real_commitment.nonce_encoding);
-        Crypto_hash_update_bignum_p(&context, real_commitment.message_encoding);
-    }
-    else
-    {
-        Crypto_hash_update_bignum_p(&context, real_commitment.nonce_encoding);
-        Crypto_hash_update_bignum_p(&context, real_commitment.message_encoding);
-        Crypto_hash_update_bignum_p(&context, fake_commitment.nonce_encoding);
-        Crypto_hash_update_bignum_p(&context, fake_commitment.message_encoding);
-    }
-    Crypto_hash_final(&result->challenge, &context);
+    //TODO
+}
 
-    sub_mod_q(real_challenge, result->challenge.digest, fake_challenge);
+// With the nonce r of the encryption (a, b) = (g^r, K^r g^m) known, the
+// simulated half of the proof can be made without a or b: pick v and the
+// fake challenge c up front, and the response v + c r makes the fake
+// commitments (g^v, K^v g^((1-2m)c)). Every exponentiation is then of g or
+// K by a fresh random exponent.
+void Crypto_encryption_precomputation_new(
+    struct Crypto_encryption_precomputation *dst)
+{
+    mpz_init(dst->nonce);
+    Crypto_encryption_rep_new(&dst->pad);
+    mpz_init(dst->proof_nonce);
+    Crypto_encryption_rep_new(&dst->proof_commitment);
+    mpz_init(dst->fake_nonce);
+    Crypto_encryption_rep_new(&dst->fake_pad);
+    mpz_init(dst->fake_challenge);
+    mpz_init(dst->fake_challenge_powers[0]);
+    mpz_init(dst->fake_challenge_powers[1]);
+}
 
-    mul_mod_q(real_response, real_challenge, nonce);
-    add_mod_q(real_response, u, real_response);
+void Crypto_encryption_precomputation_free(
+    struct Crypto_encryption_precomputation *dst)
+{
+    mpz_clear(dst->nonce);
+    Crypto_encryption_rep_free(&dst->pad);
+    mpz_clear(dst->proof_nonce);
+    Crypto_encryption_rep_free(&dst->proof_commitment);
+    mpz_clear(dst->fake_nonce);
+    Crypto_encryption_rep_free(&dst->fake_pad);
+    mpz_clear(dst->fake_challenge);
+    mpz_clear(dst->fake_challenge_powers[0]);
+    mpz_clear(dst->fake_challenge_powers[1]);
+}
 
-    if (selected)
-    {
-        Crypto_encryption_rep_copy(&result->commitment0, &fake_commitment);
-        Crypto_encryption_rep_copy(&result->commitment1, &real_commitment);
-        mpz_set(result->challenge0, fake_challenge);
-        mpz_set(result->challenge1, real_challenge);
-        mpz_set(result->response0, fake_response);
-        mpz_set(result->response1, real_response);
-    }
-    else
-    {
-        Crypto_encryption_rep_copy(&result->commitment0, &real_commitment);
-        Crypto_encryption_rep_copy(&result->commitment1, &fake_commitment);
-        mpz_set(result->challenge0, real_challenge);
-        mpz_set(result->challenge1, fake_challenge);
-        mpz_set(result->response0, real_response);
-        mpz_set(result->response1, fake_response);
-    }
+void Crypto_encryption_precomputation_swap(
+    struct Crypto_encryption_precomputation *a,
+    struct Crypto_encryption_precomputation *b)
+{
+    struct Crypto_encryption_precomputation tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
 
-    Crypto_encryption_rep_free(&real_commitment);
-    Crypto_encryption_rep_free(&fake_commitment);
+void Crypto_encryption_precompute(struct Crypto_encryption_precomputation *dst,
+                                  RandomSource source, mpz_t public_key,
+                                  const struct Crypto_fixed_bases *bases)
+{
+    RandomSource_uniform_bignum_o_q(dst->nonce, source);
+    Crypto_pow_generator(dst->pad.nonce_encoding, dst->nonce, bases);
+    Crypto_pow_public_key(dst->pad.message_encoding, public_key, dst->nonce,
+                          bases);
+
+    RandomSource_uniform_bignum_o_q(dst->proof_nonce, source);
+    Crypto_pow_generator(dst->proof_commitment.nonce_encoding,
+                         dst->proof_nonce, bases);
+    Crypto_pow_public_key(dst->proof_commitment.message_encoding, public_key,
+                          dst->proof_nonce, bases);
+
+    RandomSource_uniform_bignum_o_q(dst->fake_nonce, source);
+    Crypto_pow_generator(dst->fake_pad.nonce_encoding, dst->fake_nonce, bases);
+    Crypto_pow_public_key(dst->fake_pad.message_encoding, public_key,
+                          dst->fake_nonce, bases);
+
+    RandomSource_uniform_bignum_o_q(dst->fake_challenge, source);
+    Crypto_pow_generator(dst->fake_challenge_powers[1], dst->fake_challenge,
+                         bases);
+    div_mod_p(dst->fake_challenge_powers[0], bignum_one,
+              dst->fake_challenge_powers[1]);
+}
 
-    mpz_clear(fake_challenge);
-    mpz_clear(fake_response);
-    mpz_clear(u);
-    mpz_clear(real_challenge);
-    mpz_clear(real_response);
-    mpz_clear(scratch);
+void Crypto_encrypt_precomputed(struct encryption_rep *out, mpz_t out_nonce,
+                                const struct Crypto_encryption_precomputation *pre,
+                                mpz_t message)
+{
+    mpz_set(out_nonce, pre->nonce);
+    mpz_set(out->nonce_encoding, pre->pad.nonce_encoding);
+    mul_mod_p(out->message_encoding, pre->pad.message_encoding, message);
+}
 
-    //TODO
+void Crypto_generate_dis_proof_precomputed(
+    struct dis_proof_rep *result, struct hash base_hash, bool selected,
+    const struct Crypto_encryption_precomputation *pre,
+    struct encryption_rep encryption)
+{
+    struct encryption_rep fake_commitment;
+    Crypto_encryption_rep_scratch_new(&fake_commitment);
+    mpz_t fake_response;
+    bignum_scratch_init(fake_response);
+
+    mpz_set(fake_commitment.nonce_encoding, pre->fake_pad.nonce_encoding);
+    mul_mod_p(fake_commitment.message_encoding, pre->fake_pad.message_encoding,
+              pre->fake_challenge_powers[selected ? 0 : 1]);
+
+    mul_mod_q(fake_response, pre->fake_challenge, pre->nonce);
+    add_mod_q(fake_response, pre->fake_nonce, fake_response);
+
+    Crypto_dis_proof_respond(result, base_hash, selected, encryption, pre->nonce,
+                             pre->proof_nonce,
+                             (struct encryption_rep *)&pre->proof_commitment,
+                             &fake_commitment, pre->fake_challenge,
+                             fake_response);
+
+    Crypto_encryption_rep_scratch_free(&fake_commitment);
+    bignum_scratch_clear(fake_response);
 }
 
 //Check the proof, true means the proof checked
 bool Crypto_check_dis_proof(struct dis_proof_rep proof,
                             struct encryption_rep encryption,
-                            struct hash base_hash, mpz_t public_key)
+                            struct hash base_hash, mpz_t public_key,
+                            const struct Crypto_fixed_bases *bases)
 {
     bool result = true;
 
     mpz_t my_challenge;
-    mpz_init(my_challenge);
+    bignum_scratch_init(my_challenge);
 
     add_mod_q(my_challenge, proof.challenge0, proof.challenge1);
     //Check c = c0 + c1 mod q
     result = (0 == mpz_cmp(proof.challenge.digest, my_challenge));
 
-    //TODO we can probably share some code with the disjunctive and decryption proofs here
-    mpz_t gv, aac, glc, glckv, bbc;
-    mpz_init(gv);
-    mpz_init(aac);
-    mpz_init(glc);
-    mpz_init(glckv);
-    mpz_init(bbc);
+    // g^v0 = a0 * A^c0
+    result &= Crypto_check_exp_equation(proof.commitment0.nonce_encoding,
+                                        proof.response0, NULL, public_key,
+                                        encryption.nonce_encoding,
+                                        proof.challenge0, bases);
+
+    // g^v1 = a1 * A^c1
+    result &= Crypto_check_exp_equation(proof.commitment1.nonce_encoding,
+                                        proof.response1, NULL, public_key,
+                                        encryption.nonce_encoding,
+                                        proof.challenge1, bases);
+
+    // K^v0 = b0 * B^c0
+    result &= Crypto_check_exp_equation(proof.commitment0.message_encoding,
+                                        NULL, proof.response0, public_key,
+                                        encryption.message_encoding,
+                                        proof.challenge0, bases);
+
+    // g^c1 * K^v1 = b1 * B^c1
+    result &= Crypto_check_exp_equation(proof.commitment1.message_encoding,
+                                        proof.challenge1, proof.response1,
+                                        public_key, encryption.message_encoding,
+                                        proof.challenge1, bases);
+
+    bignum_scratch_clear(my_challenge);
+    return result;
+}
 
-    pow_mod_p(gv, generator, proof.response0);
-    pow_mod_p(aac, encryption.nonce_encoding, proof.challenge0);
-    mul_mod_p(aac, proof.commitment0.nonce_encoding, aac);
+// Each proof contributes four equations, which are combined as
+//     prod (a0^r0 a1^r1 b0^r2 b1^r3 A^(r0 c0 + r1 c1) B^(r2 c0 + r3 c1))
+//         == g^(sum r0 v0 + r1 v1 + r3 c1) * K^(sum r2 v0 + r3 v1)
+// with fresh random r's of DIS_PROOF_BATCH_EXPONENT_BITS bits. The
+// exponents are reduced mod q, so this only catches a bad proof with
+// probability about 1 - 2^-DIS_PROOF_BATCH_EXPONENT_BITS when every element
+// is in the order q subgroup: a commitment multiplied by -1, of order 2,
+// passes whenever its weight is even. Crypto_batch_check_own_dis_proofs
+// trusts the elements, having made them; Crypto_batch_check_dis_proofs
+// checks them first.
+// The left hand side is evaluated DIS_PROOF_BATCH_CHUNK proofs at a time to
+// bound the size of the multi-exponentiation tables.
+#define DIS_PROOF_BATCH_EXPONENT_BITS 64
+#define DIS_PROOF_BATCH_CHUNK 16
+#define DIS_PROOF_BATCH_TERMS 6
+
+// Whether the combined verification equation of the proofs holds, and
+// c = c0 + c1 for each of them
+static bool Crypto_combine_dis_proofs(const struct dis_proof_rep *proofs,
+                                      const struct encryption_rep *encryptions,
+                                      uint32_t num_proofs, mpz_t public_key,
+                                      const struct Crypto_fixed_bases *bases,
+                                      RandomSource source)
+{
+    bool result = true;
 
-    result &= (0 == mpz_cmp(gv, aac));
+    mpz_t g_exp, k_exp, lhs, rhs, scratch;
+    mpz_t weights[DIS_PROOF_BATCH_CHUNK][4];
+    mpz_t combined[DIS_PROOF_BATCH_CHUNK][2];
+    mpz_srcptr factors[DIS_PROOF_BATCH_CHUNK * DIS_PROOF_BATCH_TERMS];
+    mpz_srcptr exps[DIS_PROOF_BATCH_CHUNK * DIS_PROOF_BATCH_TERMS];
 
-    pow_mod_p(gv, generator, proof.response1);
-    pow_mod_p(aac, encryption.nonce_encoding, proof.challenge1);
-    mul_mod_p(aac, proof.commitment1.nonce_encoding, aac);
+    mpz_inits(g_exp, k_exp, lhs, rhs, scratch, NULL);
+    for (uint32_t k = 0; k < DIS_PROOF_BATCH_CHUNK; k++)
+    {
+        for (uint32_t j = 0; j < 4; j++)
+            mpz_init(weights[k][j]);
+        mpz_init(combined[k][0]);
+        mpz_init(combined[k][1]);
+    }
 
-    result &= (0 == mpz_cmp(gv, aac));
+    mpz_set_ui(lhs, 1);
+    for (uint32_t i = 0; i < num_proofs && result;)
+    {
+        uint32_t n = 0;
+        for (uint32_t k = 0;
+             k < DIS_PROOF_BATCH_CHUNK && i < num_proofs && result; k++, i++)
+        {
+            const struct dis_proof_rep *proof = &proofs[i];
+            const struct encryption_rep *encryption = &encryptions[i];
 
-    // K^v
-    pow_mod_p(glckv, public_key, proof.response0);
+            //Check c = c0 + c1 mod q
+            add_mod_q(scratch, proof->challenge0, proof->challenge1);
+            if (0 != mpz_cmp(proof->challenge.digest, scratch))
+                result = false;
 
-    //Beta^c
-    pow_mod_p(bbc, encryption.message_encoding, proof.challenge0);
-    //b*Beta^c
-    mul_mod_p(bbc, proof.commitment0.message_encoding, bbc);
+            for (uint32_t j = 0; j < 4 && result; j++)
+            {
+                if (RANDOM_SOURCE_SUCCESS !=
+                    RandomSource_uniform_bignum_o_q(weights[k][j], source))
+                    result = false;
+                mpz_fdiv_r_2exp(weights[k][j], weights[k][j],
+                                DIS_PROOF_BATCH_EXPONENT_BITS);
+            }
+            if (!result)
+                break;
+
+            // a0^r0 a1^r1 b0^r2 b1^r3
+            factors[n] = proof->commitment0.nonce_encoding;
+            exps[n++] = weights[k][0];
+            factors[n] = proof->commitment1.nonce_encoding;
+            exps[n++] = weights[k][1];
+            factors[n] = proof->commitment0.message_encoding;
+            exps[n++] = weights[k][2];
+            factors[n] = proof->commitment1.message_encoding;
+            exps[n++] = weights[k][3];
+
+            // A^(r0 c0 + r1 c1)
+            mul_mod_q(combined[k][0], weights[k][0], proof->challenge0);
+            mul_mod_q(scratch, weights[k][1], proof->challenge1);
+            add_mod_q(combined[k][0], combined[k][0], scratch);
+            factors[n] = encryption->nonce_encoding;
+            exps[n++] = combined[k][0];
+
+            // B^(r2 c0 + r3 c1)
+            mul_mod_q(combined[k][1], weights[k][2], proof->challenge0);
+            mul_mod_q(scratch, weights[k][3], proof->challenge1);
+            add_mod_q(combined[k][1], combined[k][1], scratch);
+            factors[n] = encryption->message_encoding;
+            exps[n++] = combined[k][1];
+
+            // g^(r0 v0 + r1 v1 + r3 c1)
+            mul_mod_q(scratch, weights[k][0], proof->response0);
+            add_mod_q(g_exp, g_exp, scratch);
+            mul_mod_q(scratch, weights[k][1], proof->response1);
+            add_mod_q(g_exp, g_exp, scratch);
+            mul_mod_q(scratch, weights[k][3], proof->challenge1);
+            add_mod_q(g_exp, g_exp, scratch);
+
+            // K^(r2 v0 + r3 v1)
+            mul_mod_q(scratch, weights[k][2], proof->response0);
+            add_mod_q(k_exp, k_exp, scratch);
+            mul_mod_q(scratch, weights[k][3], proof->response1);
+            add_mod_q(k_exp, k_exp, scratch);
+        }
+
+        if (result)
+        {
+            multi_pow_mod_p(scratch, factors, exps, n);
+            mul_mod_p(lhs, lhs, scratch);
+        }
+    }
+
+    if (result)
+    {
+        Crypto_pow_generator(rhs, g_exp, bases);
+        Crypto_pow_public_key(scratch, public_key, k_exp, bases);
+        mul_mod_p(rhs, rhs, scratch);
+        result = (0 == mpz_cmp(lhs, rhs));
+    }
+
+    for (uint32_t k = 0; k < DIS_PROOF_BATCH_CHUNK; k++)
+    {
+        for (uint32_t j = 0; j < 4; j++)
+            mpz_clear(weights[k][j]);
+        mpz_clear(combined[k][0]);
+        mpz_clear(combined[k][1]);
+    }
+    mpz_clears(g_exp, k_exp, lhs, rhs, scratch, NULL);
+
+    return result;
+}
+
+// Check each proof on its own with check, to find out which are at fault
+static bool Crypto_check_each_dis_proof(
+    const struct dis_proof_rep *proofs,
+    const struct encryption_rep *encryptions, uint32_t num_proofs,
+    struct hash base_hash, mpz_t public_key,
+    const struct Crypto_fixed_bases *bases, bool *out_valid,
+    bool (*check)(struct dis_proof_rep, struct encryption_rep, struct hash,
+                  mpz_t, const struct Crypto_fixed_bases *))
+{
+    bool result = true;
+    for (uint32_t i = 0; i < num_proofs; i++)
+    {
+        bool valid = check(proofs[i], encryptions[i], base_hash, public_key,
+                           bases);
+        if (out_valid != NULL)
+            out_valid[i] = valid;
+        result &= valid;
+    }
+    return result;
+}
 
-    result &= (0 == mpz_cmp(glckv, bbc));
+bool Crypto_batch_check_own_dis_proofs(const struct dis_proof_rep *proofs,
+                                   const struct encryption_rep *encryptions,
+                                   uint32_t num_proofs, struct hash base_hash,
+                                   mpz_t public_key,
+                                   const struct Crypto_fixed_bases *bases,
+                                   RandomSource source, bool *out_valid)
+{
+    if (!Crypto_combine_dis_proofs(proofs, encryptions, num_proofs, public_key,
+                                   bases, source))
+        return Crypto_check_each_dis_proof(proofs, encryptions, num_proofs,
+                                           base_hash, public_key, bases,
+                                           out_valid, Crypto_check_dis_proof);
+
+    if (out_valid != NULL)
+        for (uint32_t i = 0; i < num_proofs; i++)
+            out_valid[i] = true;
+    return true;
+}
 
-    //g^c1
-    pow_mod_p(glc, generator, proof.challenge1);
-    // K^v
-    pow_mod_p(glckv, public_key, proof.response1);
-    mul_mod_p(glckv, glc, glckv);
+// The group elements of a proof and the encryption it is about
+#define DIS_PROOF_NUM_ELEMENTS 6
 
-    //Beta^c
-    pow_mod_p(bbc, encryption.message_encoding, proof.challenge1);
-    //b*Beta^c
-    mul_mod_p(bbc, proof.commitment1.message_encoding, bbc);
+static void Crypto_dis_proof_elements(mpz_srcptr elements[DIS_PROOF_NUM_ELEMENTS],
+                                      const struct dis_proof_rep *proof,
+                                      const struct encryption_rep *encryption)
+{
+    elements[0] = encryption->nonce_encoding;
+    elements[1] = encryption->message_encoding;
+    elements[2] = proof->commitment0.nonce_encoding;
+    elements[3] = proof->commitment0.message_encoding;
+    elements[4] = proof->commitment1.nonce_encoding;
+    elements[5] = proof->commitment1.message_encoding;
+}
 
-    result &= (0 == mpz_cmp(glckv, bbc));
+// Whether x is a quadratic residue between 1 and p-1. Every element of the
+// order q subgroup is one, so this cheaply rejects most that are not, but
+// not all: p-1 has 16 as a factor, so -1, of order 2, passes.
+static bool Crypto_may_be_member(mpz_srcptr x)
+{
+    return mpz_sgn(x) > 0 && mpz_cmp(x, p) < 0 && mpz_jacobi(x, p) == 1;
+}
 
-    mpz_clear(gv);
-    mpz_clear(aac);
-    mpz_clear(glc);
-    mpz_clear(glckv);
-    mpz_clear(bbc);
+// Whether x is in the order q subgroup, at the cost of an exponentiation
+static bool Crypto_is_member(mpz_srcptr x)
+{
+    bool result = Crypto_may_be_member(x);
+    if (result)
+    {
+        mpz_t power;
+        bignum_scratch_init(power);
+        pow_mod_p(power, x, q);
+        result = (0 == mpz_cmp_ui(power, 1));
+        bignum_scratch_clear(power);
+    }
+    return result;
+}
 
-    mpz_clear(my_challenge);
+// Recompute the challenge of a proof from what it commits to
+static bool Crypto_check_dis_proof_challenge(const struct dis_proof_rep *proof,
+                                             const struct encryption_rep *encryption,
+                                             struct hash base_hash)
+{
+    struct hash challenge;
+    bignum_scratch_init(challenge.digest);
+    Crypto_dis_proof_challenge(&challenge, base_hash, encryption,
+                               &proof->commitment0, &proof->commitment1);
+    bool result = (0 == mpz_cmp(challenge.digest, proof->challenge.digest));
+    bignum_scratch_clear(challenge.digest);
     return result;
 }
 
+// Crypto_check_dis_proof, for a proof from anywhere
+static bool Crypto_check_received_dis_proof(struct dis_proof_rep proof,
+                                            struct encryption_rep encryption,
+                                            struct hash base_hash,
+                                            mpz_t public_key,
+                                            const struct Crypto_fixed_bases *bases)
+{
+    mpz_srcptr elements[DIS_PROOF_NUM_ELEMENTS];
+    Crypto_dis_proof_elements(elements, &proof, &encryption);
+
+    bool result = true;
+    for (uint32_t j = 0; j < DIS_PROOF_NUM_ELEMENTS && result; j++)
+        result = Crypto_is_member(elements[j]);
+
+    return result &&
+           Crypto_check_dis_proof_challenge(&proof, &encryption, base_hash) &&
+           Crypto_check_dis_proof(proof, encryption, base_hash, public_key,
+                                  bases);
+}
+
+// Membership of the order q subgroup is checked for all the elements at
+// once, as x^q == 1 for the products x of SUBGROUP_BATCH_ROUNDS random
+// subsets of them. A product is in the subgroup when all of its factors
+// are, and when one is not, half of the subsets, those that differ only in
+// whether they take it, give products outside the subgroup. So each round
+// misses an element outside it with probability at most 1/2, however small
+// its order, and a subset costs only half a multiplication per element.
+// Checking random powers of the elements instead would be cheaper, but
+// would miss elements of order 2 half the time too, since 2 divides p-1.
+#define SUBGROUP_BATCH_ROUNDS 64
+
+bool Crypto_batch_check_dis_proofs(const struct dis_proof_rep *proofs,
+                                   const struct encryption_rep *encryptions,
+                                   uint32_t num_proofs, struct hash base_hash,
+                                   mpz_t public_key,
+                                   const struct Crypto_fixed_bases *bases,
+                                   RandomSource source, bool *out_valid)
+{
+    bool result = true;
+
+    mpz_t products[SUBGROUP_BATCH_ROUNDS];
+    for (uint32_t r = 0; r < SUBGROUP_BATCH_ROUNDS; r++)
+        mpz_init_set_ui(products[r], 1);
+
+    for (uint32_t i = 0; i < num_proofs && result; i++)
+    {
+        mpz_srcptr elements[DIS_PROOF_NUM_ELEMENTS];
+        Crypto_dis_proof_elements(elements, &proofs[i], &encryptions[i]);
+
+        for (uint32_t j = 0; j < DIS_PROOF_NUM_ELEMENTS && result; j++)
+        {
+            uint64_t subsets;
+            result = Crypto_may_be_member(elements[j]) &&
+                     RANDOM_SOURCE_SUCCESS ==
+                         RandomSource_fill(source, (uint8_t *)&subsets,
+                                           sizeof(subsets));
+            for (uint32_t r = 0; r < SUBGROUP_BATCH_ROUNDS && result; r++)
+                if (subsets >> r & 1)
+                    mul_mod_p(products[r], products[r], elements[j]);
+        }
+
+        result = result && Crypto_check_dis_proof_challenge(
+                               &proofs[i], &encryptions[i], base_hash);
+    }
+
+    for (uint32_t r = 0; r < SUBGROUP_BATCH_ROUNDS && result; r++)
+    {
+        pow_mod_p(products[r], products[r], q);
+        result = (0 == mpz_cmp_ui(products[r], 1));
+    }
+
+    for (uint32_t r = 0; r < SUBGROUP_BATCH_ROUNDS; r++)
+        mpz_clear(products[r]);
+
+    // With every element in the subgroup, the random linear combination is
+    // as sound as checking each proof
+    if (result)
+        result = Crypto_combine_dis_proofs(proofs, encryptions, num_proofs,
+                                           public_key, bases, source);
+
+    if (!result)
+        return Crypto_check_each_dis_proof(proofs, encryptions, num_proofs,
+                                           base_hash, public_key, bases,
+                                           out_valid,
+                                           Crypto_check_received_dis_proof);
+
+    if (out_valid != NULL)
+        for (uint32_t i = 0; i < num_proofs; i++)
+            out_valid[i] = true;
+    return true;
+}
+
 //Encrypt a message mapped onto the group (e.g. g^message % p)
 void Crypto_encrypt(struct encryption_rep *out, mpz_t out_nonce,
                     RandomSource source, const struct joint_public_key_rep *key,
-                    mpz_t message)
+                    const struct Crypto_fixed_bases *bases, mpz_t message)
 {
 
-    RandomSource_uniform_bignum_o(out_nonce, source);
+    RandomSource_uniform_bignum_o_q(out_nonce, source);
 
-    pow_mod_p(out->nonce_encoding, generator, out_nonce);
-    pow_mod_p(out->message_encoding, key->public_key, out_nonce);
+    Crypto_pow_generator(out->nonce_encoding, out_nonce, bases);
+    Crypto_pow_public_key(out->message_encoding, key->public_key, out_nonce,
+                          bases);
     mul_mod_p(out->message_encoding, out->message_encoding, message);
 }
 
@@ -953,46 +1522,160 @@ void Crypto_encryption_homomorphic_add(struct encryption_rep *out,
     mul_mod_p(out->message_encoding, a->message_encoding, b->message_encoding);
 }
 
-//Read a uint4096 as a mpz_t
-int mpz_t_fscan(FILE *in, mpz_t out)
+void Crypto_encryption_sum_new(struct encryption_sum *sum)
+{
+    Crypto_encryption_rep_new(&sum->partial);
+    Crypto_encryption_homomorphic_zero(&sum->partial);
+    sum->num_reductions = 0;
+}
+
+void Crypto_encryption_sum_free(struct encryption_sum *sum)
+{
+    Crypto_encryption_rep_free(&sum->partial);
+}
+
+void Crypto_encryption_sum_add(struct encryption_sum *sum,
+                               const struct encryption_rep *a)
+{
+    mont_mul_p(sum->partial.nonce_encoding, sum->partial.nonce_encoding,
+               a->nonce_encoding);
+    mont_mul_p(sum->partial.message_encoding, sum->partial.message_encoding,
+               a->message_encoding);
+    sum->num_reductions++;
+}
+
+void Crypto_encryption_sum_get(struct encryption_rep *out,
+                               const struct encryption_sum *sum)
+{
+    mont_scale_p(out->nonce_encoding, sum->partial.nonce_encoding,
+                 sum->num_reductions);
+    mont_scale_p(out->message_encoding, sum->partial.message_encoding,
+                 sum->num_reductions);
+}
+
+enum Crypto_status Crypto_encryption_slots_new(struct encryption_slots *dst,
+                                               uint32_t num_selections)
+{
+    dst->num_selections = num_selections;
+    dst->limbs = calloc((size_t)num_selections * 2 * ENCRYPTION_SLOT_LIMBS,
+                        sizeof(mp_limb_t));
+    if (dst->limbs == NULL && num_selections != 0)
+        return CRYPTO_INSUFFICIENT_MEMORY;
+    return CRYPTO_SUCCESS;
+}
+
+void Crypto_encryption_slots_free(struct encryption_slots *dst)
+{
+    free(dst->limbs);
+    dst->limbs = NULL;
+}
+
+mp_limb_t *Crypto_encryption_slots_at(const struct encryption_slots *slots,
+                                      uint32_t i)
 {
-    uint4096 tmp = malloc(sizeof(struct uint4096_s));
-    if (tmp == NULL)
+    return slots->limbs + (size_t)i * 2 * ENCRYPTION_SLOT_LIMBS;
+}
+
+// Copy z into a slot, padding it with zeros, unless it is 2^4096 or more
+static bool Crypto_encryption_slot_set(mp_limb_t *slot, const mpz_t z)
+{
+    size_t size = mpz_size(z);
+    if (size > ENCRYPTION_SLOT_LIMBS)
+        return false;
+    mpn_copyi(slot, mpz_limbs_read(z), size);
+    mpn_zero(slot + size, ENCRYPTION_SLOT_LIMBS - size);
+    return true;
+}
+
+bool Crypto_encryption_slots_set(struct encryption_slots *slots, uint32_t i,
+                                 const struct encryption_rep *src)
+{
+    mp_limb_t *at = Crypto_encryption_slots_at(slots, i);
+    return Crypto_encryption_slot_set(at, src->nonce_encoding) &&
+           Crypto_encryption_slot_set(at + ENCRYPTION_SLOT_LIMBS,
+                                      src->message_encoding);
+}
+
+void Crypto_encryption_slots_view(struct encryption_rep *out,
+                                  const struct encryption_slots *slots,
+                                  uint32_t i)
+{
+    const mp_limb_t *at = Crypto_encryption_slots_at(slots, i);
+    // mpz_roinit_n trims the zeros from the top of the slot
+    mpz_roinit_n(out->nonce_encoding, at, ENCRYPTION_SLOT_LIMBS);
+    mpz_roinit_n(out->message_encoding, at + ENCRYPTION_SLOT_LIMBS,
+                 ENCRYPTION_SLOT_LIMBS);
+}
+
+enum Crypto_status
+Crypto_encryption_slots_sum_new(struct encryption_slots_sum *sum,
+                                uint32_t num_selections)
+{
+    sum->num_reductions = 0;
+    enum Crypto_status status =
+        Crypto_encryption_slots_new(&sum->partial, num_selections);
+
+    // The homomorphic zero, (1, 1), for every selection
+    if (status == CRYPTO_SUCCESS)
+        for (uint32_t i = 0; i < 2 * num_selections; i++)
+            sum->partial.limbs[(size_t)i * ENCRYPTION_SLOT_LIMBS] = 1;
+
+    return status;
+}
+
+void Crypto_encryption_slots_sum_free(struct encryption_slots_sum *sum)
+{
+    Crypto_encryption_slots_free(&sum->partial);
+}
+
+void Crypto_encryption_slots_sum_add(struct encryption_slots_sum *sum,
+                                     const struct encryption_slots *a)
+{
+    assert(a->num_selections == sum->partial.num_selections);
+
+    for (size_t i = 0; i < (size_t)2 * a->num_selections; i++)
     {
-        // TODO: return non-zero failure code
-        return 0;
+        mp_limb_t *partial = sum->partial.limbs + i * ENCRYPTION_SLOT_LIMBS;
+        mont_mul_p_n(partial, partial, a->limbs + i * ENCRYPTION_SLOT_LIMBS);
     }
+    sum->num_reductions++;
+}
+
+void Crypto_encryption_slots_sum_get(struct encryption_rep *out,
+                                     const struct encryption_slots_sum *sum,
+                                     uint32_t i)
+{
+    struct encryption_rep partial;
+    Crypto_encryption_slots_view(&partial, &sum->partial, i);
+    mont_scale_p(out->nonce_encoding, partial.nonce_encoding,
+                 sum->num_reductions);
+    mont_scale_p(out->message_encoding, partial.message_encoding,
+                 sum->num_reductions);
+}
 
-    int res = uint4096_fscan(in, tmp);
-    import_uint4096(out, tmp);
-    free(tmp);
+//Read a uint4096 as a mpz_t
+int mpz_t_fscan(FILE *in, mpz_t out)
+{
+    struct uint4096_s tmp;
+    int res = uint4096_fscan(in, &tmp);
+    if (res)
+        import_uint4096(out, &tmp);
     return res;
 }
 
 bool mpz_t_fprint(FILE *out, const mpz_t z)
 {
-    bool ret = false;
-    uint4096 tmp = NULL;
-    bignum_status export_status = export_to_uint4096(z, &tmp);
-    if (export_status == BIGNUM_SUCCESS)
+    if (mpz_sizeinbase(z, 2) > 4096)
     {
-        if (tmp != NULL)
-        {
-            ret = uint4096_fprint(out, tmp);
-            free(tmp);
-        }
-        else
-        {
-            DEBUG_PRINT(("\nmpz_t_fprint: temp is null - FAILED!\n"));
-        }
-        
+        DEBUG_PRINT(("\nmpz_t_fprint: value too large - FAILED!\n"));
+        return false;
     }
-    else
-    {
-        DEBUG_PRINT(("\nmpz_t_fprint: export_to_uint4096 - FAILED!\n"));
-    }
-    
-    return ret;
+
+    // Export into the low words, leaving the high words zero
+    struct uint4096_s tmp = {{0}};
+    size_t words = (mpz_sizeinbase(z, 2) + 63) / 64;
+    mpz_export(&tmp.words[UINT4096_WORD_COUNT - words], NULL, 1, 8, 0, 0, z);
+    return uint4096_fprint(out, &tmp);
 }
 
 bool Crypto_encryption_fprint(FILE *out, const struct encryption_rep *rep)
@@ -41,8 +41,9 @@ void Crypto_private_key_copy(struct private_key *dst,
 void Crypto_hash_final(struct hash *out, SHA2_CTX *context);
 void Crypto_hash_reduce(struct hash *out, raw_hash bytes);
 
-void Crypto_hash_update_bignum_p(SHA2_CTX *context, mpz_t num);
-void Crypto_hash_update_bignum_q(SHA2_CTX *context, mpz_t num);
+/* Hash a number mod p or mod q as 512 or 32 bytes, without allocating */
+void Crypto_hash_update_bignum_p(SHA2_CTX *context, const mpz_t num);
+void Crypto_hash_update_bignum_q(SHA2_CTX *context, const mpz_t num);
 
 /* A NIZKP of knowledge of the secrets associated with a public key */
 struct schnorr_proof
@@ -140,6 +141,19 @@ void Crypto_generate_joint_public_key(struct joint_public_key_rep *dst,
                                       struct public_key const *public_keys,
                                       uint32_t num_keys);
 
+/* Fixed-base tables for the generator and one public key, built once by
+ * whoever makes many encryptions or proofs under the same key. Functions
+ * taking a bases argument accept NULL and fall back to pow_mod_p. */
+struct Crypto_fixed_bases
+{
+    struct fixed_base_table generator;
+    struct fixed_base_table public_key;
+};
+
+enum Crypto_status Crypto_fixed_bases_new(struct Crypto_fixed_bases *dst,
+                                          const mpz_t public_key);
+void Crypto_fixed_bases_free(struct Crypto_fixed_bases *dst);
+
 struct encryption_rep
 {
     mpz_t nonce_encoding;
@@ -148,12 +162,74 @@ struct encryption_rep
 
 void Crypto_encrypt(struct encryption_rep *out, mpz_t out_nonce,
                     RandomSource source, const struct joint_public_key_rep *key,
-                    mpz_t message);
+                    const struct Crypto_fixed_bases *bases, mpz_t message);
 void Crypto_encryption_homomorphic_zero(struct encryption_rep *out);
 void Crypto_encryption_homomorphic_add(struct encryption_rep *out,
                                        const struct encryption_rep *a,
                                        const struct encryption_rep *b);
 
+/* A homomorphic sum of many encryptions. Each addition is one Montgomery
+ * product per component, with no division; the factors of 2^-4096 they
+ * leave behind are taken out once, by Crypto_encryption_sum_get. */
+struct encryption_sum
+{
+    struct encryption_rep partial;
+    uint64_t num_reductions;
+};
+
+void Crypto_encryption_sum_new(struct encryption_sum *sum);
+void Crypto_encryption_sum_free(struct encryption_sum *sum);
+void Crypto_encryption_sum_add(struct encryption_sum *sum,
+                               const struct encryption_rep *a);
+void Crypto_encryption_sum_get(struct encryption_rep *out,
+                               const struct encryption_sum *sum);
+
+/* The encryptions of num_selections selections in one buffer of fixed
+ * ENCRYPTION_SLOT_SIZE byte slots, each selection's nonce encoding then its
+ * message encoding, as limbs least significant first. Filling, reading and
+ * summing them allocates nothing per number. */
+#define ENCRYPTION_SLOT_SIZE 512
+#define ENCRYPTION_SLOT_LIMBS MONT_P_LIMBS
+
+struct encryption_slots
+{
+    uint32_t num_selections;
+    mp_limb_t *limbs;
+};
+
+enum Crypto_status Crypto_encryption_slots_new(struct encryption_slots *dst,
+                                               uint32_t num_selections);
+void Crypto_encryption_slots_free(struct encryption_slots *dst);
+/* The slots of selection i: its nonce encoding, then its message encoding */
+mp_limb_t *Crypto_encryption_slots_at(const struct encryption_slots *slots,
+                                      uint32_t i);
+/* Copy src into the slots of selection i. Returns false if either of its
+ * numbers is too large for a slot, leaving the slots partly written. */
+bool Crypto_encryption_slots_set(struct encryption_slots *slots, uint32_t i,
+                                 const struct encryption_rep *src);
+/* Point out at selection i without copying it. out is read-only, must not
+ * be cleared, and lasts only as long as the slots are left alone. */
+void Crypto_encryption_slots_view(struct encryption_rep *out,
+                                  const struct encryption_slots *slots,
+                                  uint32_t i);
+
+/* Crypto_encryption_sum for every selection of a ballot at once */
+struct encryption_slots_sum
+{
+    struct encryption_slots partial;
+    uint64_t num_reductions;
+};
+
+enum Crypto_status
+Crypto_encryption_slots_sum_new(struct encryption_slots_sum *sum,
+                                uint32_t num_selections);
+void Crypto_encryption_slots_sum_free(struct encryption_slots_sum *sum);
+void Crypto_encryption_slots_sum_add(struct encryption_slots_sum *sum,
+                                     const struct encryption_slots *a);
+void Crypto_encryption_slots_sum_get(struct encryption_rep *out,
+                                     const struct encryption_slots_sum *sum,
+                                     uint32_t i);
+
 bool Crypto_encryption_fprint(FILE *out, const struct encryption_rep *rep);
 
 struct cp_proof_rep
@@ -182,30 +258,110 @@ void Crypto_dis_proof_free(struct dis_proof_rep *dst);
 bool Crypto_check_aggregate_cp_proof(struct cp_proof_rep proof,
                                       struct encryption_rep encryption,
                                       struct hash base_hash, mpz_t public_key,
+                                      const struct Crypto_fixed_bases *bases,
                                       uint32_t l_int);
 
 void Crypto_generate_aggregate_cp_proof(struct cp_proof_rep *result,
                                         RandomSource source, mpz_t nonce,
                                         struct encryption_rep encryption,
                                         struct hash base_hash,
-                                        mpz_t public_key);
+                                        mpz_t public_key,
+                                        const struct Crypto_fixed_bases *bases);
 
 void Crypto_generate_decryption_cp_proof(
     struct cp_proof_rep *result, mpz_t secret_key, mpz_t partial_decryption,
-    struct encryption_rep aggregate_encryption, struct hash base_hash);
+    struct encryption_rep aggregate_encryption, struct hash base_hash,
+    const struct Crypto_fixed_bases *bases);
 
 void Crypto_generate_dis_proof(struct dis_proof_rep *result,
                                RandomSource source, struct hash base_hash,
                                bool selected, mpz_t public_key,
+                               const struct Crypto_fixed_bases *bases,
                                struct encryption_rep encryption, mpz_t nonce);
 
+/* The exponentiations of encrypting a selection and proving it is 0 or 1,
+ * which do not depend on the selection and so can be done ahead of time.
+ * Each precomputation must be used for at most one encryption. */
+struct Crypto_encryption_precomputation
+{
+    // the nonce r of the encryption and the pad (g^r, K^r)
+    mpz_t nonce;
+    struct encryption_rep pad;
+    // the commitment (g^u, K^u) of the real half of the proof
+    mpz_t proof_nonce;
+    struct encryption_rep proof_commitment;
+    // the simulated half of the proof: (g^v, K^v), the challenge c, and
+    // g^-c and g^c for a selection of 1 and 0 respectively
+    mpz_t fake_nonce;
+    struct encryption_rep fake_pad;
+    mpz_t fake_challenge;
+    mpz_t fake_challenge_powers[2];
+};
+
+void Crypto_encryption_precomputation_new(
+    struct Crypto_encryption_precomputation *dst);
+void Crypto_encryption_precomputation_free(
+    struct Crypto_encryption_precomputation *dst);
+void Crypto_encryption_precomputation_swap(
+    struct Crypto_encryption_precomputation *a,
+    struct Crypto_encryption_precomputation *b);
+void Crypto_encryption_precompute(struct Crypto_encryption_precomputation *dst,
+                                  RandomSource source, mpz_t public_key,
+                                  const struct Crypto_fixed_bases *bases);
+
+/* Crypto_encrypt and Crypto_generate_dis_proof from a precomputation, with
+ * a few multiplications and no exponentiations. */
+void Crypto_encrypt_precomputed(struct encryption_rep *out, mpz_t out_nonce,
+                                const struct Crypto_encryption_precomputation *pre,
+                                mpz_t message);
+void Crypto_generate_dis_proof_precomputed(
+    struct dis_proof_rep *result, struct hash base_hash, bool selected,
+    const struct Crypto_encryption_precomputation *pre,
+    struct encryption_rep encryption);
+/* Crypto_generate_aggregate_cp_proof, using the pad of a precomputation
+ * as its commitment. */
+void Crypto_generate_aggregate_cp_proof_precomputed(
+    struct cp_proof_rep *result, mpz_t nonce, struct encryption_rep encryption,
+    struct hash base_hash, const struct Crypto_encryption_precomputation *pre);
+
 bool Crypto_check_decryption_cp_proof(
     struct cp_proof_rep proof, mpz_t public_key, mpz_t partial_decryption,
-    struct encryption_rep aggregate_encryption, struct hash base_hash);
+    struct encryption_rep aggregate_encryption, struct hash base_hash,
+    const struct Crypto_fixed_bases *bases);
 
 bool Crypto_check_dis_proof(struct dis_proof_rep proof,
                             struct encryption_rep encryption,
-                            struct hash base_hash, mpz_t public_key);
+                            struct hash base_hash, mpz_t public_key,
+                            const struct Crypto_fixed_bases *bases);
+
+/* Check num_proofs disjunctive proofs made by this process at once with a
+ * random linear combination of their verification equations, falling back
+ * to Crypto_check_dis_proof one proof at a time only when the combination
+ * does not hold. Returns true if every proof checked; if out_valid is not
+ * NULL it receives the result for each proof. The combined check does not
+ * check that the encryptions and commitments are in the order q subgroup,
+ * and passes some proofs with elements outside it, so it must not be used
+ * for proofs from anywhere else; use Crypto_batch_check_dis_proofs for
+ * those. */
+bool Crypto_batch_check_own_dis_proofs(const struct dis_proof_rep *proofs,
+                                   const struct encryption_rep *encryptions,
+                                   uint32_t num_proofs, struct hash base_hash,
+                                   mpz_t public_key,
+                                   const struct Crypto_fixed_bases *bases,
+                                   RandomSource source, bool *out_valid);
+
+/* Crypto_batch_check_own_dis_proofs, for proofs from anywhere, such as
+ * those of a whole election under audit. It also checks, for all the
+ * proofs at once, that their encryptions and commitments are in the order
+ * q subgroup and that their challenges are the hashes of what they commit
+ * to; a proof that fails is found by checking each of these for each proof
+ * on its own. */
+bool Crypto_batch_check_dis_proofs(const struct dis_proof_rep *proofs,
+                                   const struct encryption_rep *encryptions,
+                                   uint32_t num_proofs, struct hash base_hash,
+                                   mpz_t public_key,
+                                   const struct Crypto_fixed_bases *bases,
+                                   RandomSource source, bool *out_valid);
 
 void Crypto_cp_proof_new(struct cp_proof_rep *dst);
 void Crypto_cp_proof_free(struct cp_proof_rep *dst);
@@ -235,6 +391,7 @@ struct Crypto_encrypted_ballot_new_r
 };
 
 int mpz_t_fscan(FILE *in, mpz_t out);
+bool mpz_t_fprint(FILE *out, const mpz_t z);
 
 void Crypto_encryption_rep_new(struct encryption_rep *dst);
 void Crypto_encryption_rep_free(struct encryption_rep *dst);
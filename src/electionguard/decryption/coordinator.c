@@ -28,6 +28,10 @@ struct Decryption_Coordinator_s
     bool responded[MAX_TRUSTEES];
     // How many decryption_fragments we have received to compensate for each trustee
     uint32_t num_decryption_fragments[MAX_TRUSTEES];
+
+    // Baby steps for recovering the tallies from g^tally
+    bool dlog_table_built;
+    struct dlog_table dlog_table;
 };
 
 struct Decryption_Coordinator_new_r
@@ -80,9 +84,71 @@ void Decryption_Coordinator_free(Decryption_Coordinator coordinator)
 
     coordinator->tallies_initialized = false;
 
+    if (coordinator->dlog_table_built)
+        dlog_table_free(&coordinator->dlog_table);
+
     free(coordinator); 
 }
 
+static enum Decryption_Coordinator_status
+Decryption_Coordinator_bignum_status_convert(bignum_status status)
+{
+    switch (status)
+    {
+    case BIGNUM_SUCCESS:
+        return DECRYPTION_COORDINATOR_SUCCESS;
+    case BIGNUM_INSUFFICIENT_MEMORY:
+        return DECRYPTION_COORDINATOR_INSUFFICIENT_MEMORY;
+    default:
+        return DECRYPTION_COORDINATOR_IO_ERROR;
+    }
+}
+
+enum Decryption_Coordinator_status
+Decryption_Coordinator_build_dlog_table(Decryption_Coordinator c,
+                                        uint64_t max_tally)
+{
+    if (c->dlog_table_built)
+        dlog_table_free(&c->dlog_table);
+
+    enum Decryption_Coordinator_status status =
+        Decryption_Coordinator_bignum_status_convert(
+            dlog_table_new(&c->dlog_table, max_tally));
+    c->dlog_table_built = status == DECRYPTION_COORDINATOR_SUCCESS;
+
+    return status;
+}
+
+enum Decryption_Coordinator_status
+Decryption_Coordinator_read_dlog_table(Decryption_Coordinator c, FILE *in)
+{
+    if (c->dlog_table_built)
+        dlog_table_free(&c->dlog_table);
+
+    enum Decryption_Coordinator_status status =
+        Decryption_Coordinator_bignum_status_convert(
+            dlog_table_fread(&c->dlog_table, in));
+    c->dlog_table_built = status == DECRYPTION_COORDINATOR_SUCCESS;
+
+    return status;
+}
+
+enum Decryption_Coordinator_status
+Decryption_Coordinator_write_dlog_table(Decryption_Coordinator c, FILE *out)
+{
+    enum Decryption_Coordinator_status status = DECRYPTION_COORDINATOR_SUCCESS;
+
+    if (!c->dlog_table_built)
+        status = Decryption_Coordinator_build_dlog_table(
+            c, DECRYPTION_COORDINATOR_DEFAULT_MAX_TALLY);
+
+    if (status == DECRYPTION_COORDINATOR_SUCCESS)
+        status = Decryption_Coordinator_bignum_status_convert(
+            dlog_table_fwrite(&c->dlog_table, out));
+
+    return status;
+}
+
 enum Decryption_Coordinator_status
 Decryption_Coordinator_receive_share(Decryption_Coordinator coordinator,
                                      struct decryption_share share)
@@ -425,6 +491,10 @@ Decryption_Coordinator_all_fragments_received(
     if (!Decryption_Coordinator_all_trustees_seen_or_compensated(c))
         status = DECRYPTION_COORDINATOR_MISSING_TRUSTEES;
 
+    if (status == DECRYPTION_COORDINATOR_SUCCESS && !c->dlog_table_built)
+        status = Decryption_Coordinator_build_dlog_table(
+            c, DECRYPTION_COORDINATOR_DEFAULT_MAX_TALLY);
+
     for (uint64_t i = 0;
          i < c->num_tallies && status == DECRYPTION_COORDINATOR_SUCCESS; i++)
     {
@@ -443,7 +513,7 @@ Decryption_Coordinator_all_fragments_received(
                   c->tallies[i].nonce_encoding);
 
         //This M should be equal to g^tally
-        if (!log_generator_mod_p(decrypted_tally, M))
+        if (!log_generator_mod_p(decrypted_tally, M, &c->dlog_table))
         {
             status = DECRYPTION_COORDINATOR_IO_ERROR;
         }
@@ -1,16 +1,34 @@
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <electionguard/decryption/trustee.h>
 #include <electionguard/secure_zero_memory.h>
 
+#include "ballot_record.h"
 #include "crypto_reps.h"
 #include "decryption/message_reps.h"
 #include "serialize/decryption.h"
 #include "serialize/trustee_state.h"
 #include "trustee_state_rep.h"
 
+#ifdef _WIN32
+#define fseeko _fseeki64
+#define ftello _ftelli64
+#endif
+
+// A decryption proof left for Decryption_Trustee_verify_deferred, made with
+// the private key of trustee key_owner: this trustee's own, or one it holds
+// a share of
+struct Decryption_Trustee_deferred_proof
+{
+    struct cp_proof_rep proof;
+    mpz_t partial_decryption;
+    struct encryption_rep encryption;
+    uint32_t key_owner;
+};
+
 struct Decryption_Trustee_s
 {
     uint32_t num_trustees;
@@ -18,12 +36,23 @@ struct Decryption_Trustee_s
     uint32_t num_selections;
     uint32_t index;
     struct encryption_rep tallies[MAX_SELECTIONS];
+    // ballots in the voting records tallied, cast or spoiled
+    uint64_t num_ballots;
     //@secret the private key must not be leaked from the system
     struct private_key private_key;
+    // g^private_key, and precomputed powers of it and of the generator
+    mpz_t public_key;
+    struct Crypto_fixed_bases bases;
     struct hash base_hash;
     struct encrypted_key_share my_key_shares
         [MAX_TRUSTEES]; //The shares other trustees have sent to this trustee
     rsa_private_key rsa_private_key;
+    enum Crypto_verification_policy verification_policy;
+    // proofs made so far, for sampling
+    uint64_t num_proofs;
+    struct Decryption_Trustee_deferred_proof *deferred;
+    size_t num_deferred;
+    size_t deferred_capacity;
 };
 
 struct Decryption_Trustee_new_r
@@ -33,6 +62,7 @@ Decryption_Trustee_new(uint32_t num_trustees, uint32_t threshold,
 {
     struct Decryption_Trustee_new_r result;
     result.status = DECRYPTION_TRUSTEE_SUCCESS;
+    result.decryptor = NULL;
 
     if (!(1 <= threshold && threshold <= num_trustees &&
           num_trustees <= MAX_TRUSTEES))
@@ -99,6 +129,20 @@ Decryption_Trustee_new(uint32_t num_trustees, uint32_t threshold,
         Crypto_private_key_init(&result.decryptor->private_key, threshold);
         Crypto_private_key_copy(&result.decryptor->private_key,
                                 &state_rep.private_key);
+        // Keys made before coefficients were drawn mod q hold 4096-bit
+        // ones. Every number they raise is in the order q subgroup, so
+        // reducing them changes no result and shortens each exponentiation.
+        for (uint32_t i = 0; i < threshold; i++)
+            mod_q(result.decryptor->private_key.coefficients[i],
+                  result.decryptor->private_key.coefficients[i]);
+
+        mpz_init(result.decryptor->public_key);
+        pow_mod_p(result.decryptor->public_key, generator,
+                  result.decryptor->private_key.coefficients[0]);
+        if (Crypto_fixed_bases_new(&result.decryptor->bases,
+                                   result.decryptor->public_key) !=
+            CRYPTO_SUCCESS)
+            result.status = DECRYPTION_TRUSTEE_INSUFFICIENT_MEMORY;
 
         Crypto_rsa_private_key_new(&result.decryptor->rsa_private_key);
         Crypto_rsa_private_key_copy(&result.decryptor->rsa_private_key,
@@ -113,6 +157,14 @@ Decryption_Trustee_new(uint32_t num_trustees, uint32_t threshold,
         }
     }
 
+    // A trustee that failed part way through holds the private key, so it
+    // is torn down rather than left to the caller, who has nothing to free
+    if (result.status != DECRYPTION_TRUSTEE_SUCCESS && result.decryptor != NULL)
+    {
+        Decryption_Trustee_free(result.decryptor);
+        result.decryptor = NULL;
+    }
+
     // Free the message
     Crypto_private_key_free(&state_rep.private_key, threshold);
     Crypto_rsa_private_key_free(&state_rep.rsa_private_key);
@@ -125,23 +177,183 @@ Decryption_Trustee_new(uint32_t num_trustees, uint32_t threshold,
     return result;
 }
 
+static void
+Decryption_Trustee_discard_deferred(Decryption_Trustee decryption_trustee)
+{
+    for (size_t i = 0; i < decryption_trustee->num_deferred; i++)
+    {
+        struct Decryption_Trustee_deferred_proof *entry =
+            &decryption_trustee->deferred[i];
+        mpz_clear(entry->proof.challenge.digest);
+        Crypto_cp_proof_free(&entry->proof);
+        mpz_clear(entry->partial_decryption);
+        Crypto_encryption_rep_free(&entry->encryption);
+    }
+    free(decryption_trustee->deferred);
+    decryption_trustee->deferred = NULL;
+    decryption_trustee->num_deferred = 0;
+    decryption_trustee->deferred_capacity = 0;
+}
+
+// Overwrite the limbs of a secret before they go back to the allocator
+static void Decryption_Trustee_wipe(mpz_t secret)
+{
+    size_t size = mpz_size(secret);
+    if (size > 0)
+        secure_zero_memory(mpz_limbs_modify(secret, size),
+                           size * sizeof(mp_limb_t));
+}
+
 void Decryption_Trustee_free(Decryption_Trustee decryption_trustee)
 {
+    for (uint32_t i = 0; i < decryption_trustee->threshold; i++)
+        Decryption_Trustee_wipe(decryption_trustee->private_key.coefficients[i]);
+    Decryption_Trustee_wipe(decryption_trustee->rsa_private_key.d);
+    Decryption_Trustee_wipe(decryption_trustee->rsa_private_key.p);
+    Decryption_Trustee_wipe(decryption_trustee->rsa_private_key.q);
+
     for (size_t i = 0; i < decryption_trustee->num_selections; i++)
     {
         Crypto_encryption_rep_free(&decryption_trustee->tallies[i]);
     }
     Crypto_private_key_free(&decryption_trustee->private_key, decryption_trustee->threshold);
+    Crypto_fixed_bases_free(&decryption_trustee->bases);
+    mpz_clear(decryption_trustee->public_key);
     Crypto_rsa_private_key_free(&decryption_trustee->rsa_private_key);
     for (size_t i = 0; i < decryption_trustee->num_trustees; i++)
     {
         Crypto_encrypted_key_share_free(&decryption_trustee->my_key_shares[i]);
     }
     mpz_clear(decryption_trustee->base_hash.digest);
+    Decryption_Trustee_discard_deferred(decryption_trustee);
 
     free(decryption_trustee);
 }
 
+void Decryption_Trustee_set_verification_policy(
+    Decryption_Trustee decryption_trustee,
+    enum Crypto_verification_policy policy)
+{
+    decryption_trustee->verification_policy = policy;
+}
+
+// Check a proof made with the private key of key_owner, which is secret
+// unless it is this trustee's own
+static bool Decryption_Trustee_check_proof(Decryption_Trustee decryption_trustee,
+                                           struct cp_proof_rep *proof,
+                                           mpz_t partial_decryption,
+                                           struct encryption_rep *encryption,
+                                           uint32_t key_owner, mpz_t secret)
+{
+    if (key_owner == decryption_trustee->index)
+        return Crypto_check_decryption_cp_proof(
+            *proof, decryption_trustee->public_key, partial_decryption,
+            *encryption, decryption_trustee->base_hash,
+            &decryption_trustee->bases);
+
+    mpz_t public_key;
+    mpz_init(public_key);
+    pow_mod_p_fixed(public_key, &decryption_trustee->bases.generator, secret);
+    // the public key is not our own, so no table for it
+    bool valid = Crypto_check_decryption_cp_proof(
+        *proof, public_key, partial_decryption, *encryption,
+        decryption_trustee->base_hash, NULL);
+    mpz_clear(public_key);
+    return valid;
+}
+
+// Check a proof the trustee just made, keep it for later, or let it go,
+// according to the verification policy
+static enum Decryption_Trustee_status
+Decryption_Trustee_verify_proof(Decryption_Trustee decryption_trustee,
+                                struct cp_proof_rep *proof,
+                                mpz_t partial_decryption,
+                                struct encryption_rep *encryption,
+                                uint32_t key_owner, mpz_t secret)
+{
+    bool check;
+    switch (decryption_trustee->verification_policy)
+    {
+    case CRYPTO_VERIFY_SAMPLED:
+        check = decryption_trustee->num_proofs++ % CRYPTO_VERIFY_SAMPLE_RATE == 0;
+        break;
+    case CRYPTO_VERIFY_DEFERRED:
+        check = false;
+        break;
+    default:
+        check = true;
+        break;
+    }
+
+    if (check)
+        return Decryption_Trustee_check_proof(decryption_trustee, proof,
+                                              partial_decryption, encryption,
+                                              key_owner, secret)
+                   ? DECRYPTION_TRUSTEE_SUCCESS
+                   : DECRYPTION_TRUSTEE_PROOF_ERROR;
+
+    if (decryption_trustee->verification_policy != CRYPTO_VERIFY_DEFERRED)
+        return DECRYPTION_TRUSTEE_SUCCESS;
+
+    if (decryption_trustee->num_deferred == decryption_trustee->deferred_capacity)
+    {
+        size_t capacity = decryption_trustee->deferred_capacity == 0
+                              ? MAX_SELECTIONS
+                              : 2 * decryption_trustee->deferred_capacity;
+        struct Decryption_Trustee_deferred_proof *deferred =
+            realloc(decryption_trustee->deferred,
+                    capacity * sizeof(struct Decryption_Trustee_deferred_proof));
+        if (deferred == NULL)
+            return DECRYPTION_TRUSTEE_INSUFFICIENT_MEMORY;
+        decryption_trustee->deferred = deferred;
+        decryption_trustee->deferred_capacity = capacity;
+    }
+
+    struct Decryption_Trustee_deferred_proof *entry =
+        &decryption_trustee->deferred[decryption_trustee->num_deferred++];
+    Crypto_cp_proof_new(&entry->proof);
+    Crypto_encryption_rep_copy(&entry->proof.commitment, &proof->commitment);
+    mpz_init_set(entry->proof.challenge.digest, proof->challenge.digest);
+    mpz_set(entry->proof.response, proof->response);
+    mpz_init_set(entry->partial_decryption, partial_decryption);
+    Crypto_encryption_rep_new(&entry->encryption);
+    Crypto_encryption_rep_copy(&entry->encryption, encryption);
+    entry->key_owner = key_owner;
+
+    return DECRYPTION_TRUSTEE_SUCCESS;
+}
+
+enum Decryption_Trustee_status
+Decryption_Trustee_verify_deferred(Decryption_Trustee decryption_trustee)
+{
+    enum Decryption_Trustee_status status = DECRYPTION_TRUSTEE_SUCCESS;
+
+    mpz_t secret;
+    mpz_init(secret);
+
+    for (size_t i = 0; i < decryption_trustee->num_deferred; i++)
+    {
+        struct Decryption_Trustee_deferred_proof *entry =
+            &decryption_trustee->deferred[i];
+
+        if (entry->key_owner != decryption_trustee->index)
+            RSA_Decrypt(
+                secret,
+                decryption_trustee->my_key_shares[entry->key_owner].encrypted,
+                &decryption_trustee->rsa_private_key);
+
+        if (!Decryption_Trustee_check_proof(
+                decryption_trustee, &entry->proof, entry->partial_decryption,
+                &entry->encryption, entry->key_owner, secret))
+            status = DECRYPTION_TRUSTEE_PROOF_ERROR;
+    }
+
+    mpz_clear(secret);
+    Decryption_Trustee_discard_deferred(decryption_trustee);
+
+    return status;
+}
+
 static enum Decryption_Trustee_status
 Decryption_Trustee_read_ballot(FILE *in, uint64_t *ballot_id, bool *cast,
                                uint32_t num_selections,
@@ -195,28 +407,77 @@ Decryption_Trustee_read_ballot(FILE *in, uint64_t *ballot_id, bool *cast,
     return status;
 }
 
-static void Decryption_Trustee_accum_tally(Decryption_Trustee decryption_trustee,
-                                           struct encryption_rep *selections)
+// Add a ballot read from a text record to a partial tally, by way of slots,
+// rejecting numbers too large to be encryptions
+static enum Decryption_Trustee_status
+Decryption_Trustee_accum_tally(struct encryption_slots_sum *tally,
+                               struct encryption_slots *slots,
+                               struct encryption_rep *selections)
+{
+    for (uint32_t i = 0; i < slots->num_selections; i++)
+        if (!Crypto_encryption_slots_set(slots, i, &selections[i]))
+            return DECRYPTION_TRUSTEE_MALFORMED_INPUT;
+
+    Crypto_encryption_slots_sum_add(tally, slots);
+    return DECRYPTION_TRUSTEE_SUCCESS;
+}
+
+// Start a partial tally, along with the slots its ballots are read into
+static enum Decryption_Trustee_status
+Decryption_Trustee_new_tally(Decryption_Trustee decryption_trustee,
+                             struct encryption_slots_sum *tally,
+                             struct encryption_slots *slots)
 {
-    for (size_t i = 0; i < decryption_trustee->num_selections; i++)
+    const uint32_t num_selections = decryption_trustee->num_selections;
+    enum Crypto_status tally_status =
+        Crypto_encryption_slots_sum_new(tally, num_selections);
+    enum Crypto_status slots_status =
+        Crypto_encryption_slots_new(slots, num_selections);
+
+    if (tally_status != CRYPTO_SUCCESS || slots_status != CRYPTO_SUCCESS)
+        return DECRYPTION_TRUSTEE_INSUFFICIENT_MEMORY;
+
+    return DECRYPTION_TRUSTEE_SUCCESS;
+}
+
+// Add a partial tally of num_ballots ballots into the trustee's tally, and
+// free it
+static void
+Decryption_Trustee_combine_tally(Decryption_Trustee decryption_trustee,
+                                 struct encryption_slots_sum *tallies,
+                                 uint64_t num_ballots, bool add)
+{
+    if (add)
+        decryption_trustee->num_ballots += num_ballots;
+
+    struct encryption_rep tally;
+    Crypto_encryption_rep_new(&tally);
+
+    for (uint32_t j = 0; j < decryption_trustee->num_selections; j++)
     {
-        Crypto_encryption_homomorphic_add(
-            &decryption_trustee->tallies[i], 
-            &decryption_trustee->tallies[i],
-            &selections[i]
-        );
+        if (add)
+        {
+            Crypto_encryption_slots_sum_get(&tally, tallies, j);
+            Crypto_encryption_homomorphic_add(&decryption_trustee->tallies[j],
+                                              &decryption_trustee->tallies[j],
+                                              &tally);
+        }
     }
+
+    Crypto_encryption_rep_free(&tally);
+    Crypto_encryption_slots_sum_free(tallies);
 }
 
-enum Decryption_Trustee_status
-Decryption_Trustee_tally_voting_record(Decryption_Trustee decryption_trustee, FILE *in)
+// Read the number of ballots and check the number of selections
+static enum Decryption_Trustee_status
+Decryption_Trustee_read_header(Decryption_Trustee decryption_trustee, FILE *in,
+                               uint64_t *num_ballots)
 {
     enum Decryption_Trustee_status status = DECRYPTION_TRUSTEE_SUCCESS;
 
     // get the number of ballots from the ballots file header
-    uint64_t num_ballots;
     {
-        int num_read = fscanf(in, "%" PRIu64 "\n", &num_ballots);
+        int num_read = fscanf(in, "%" PRIu64 "\n", num_ballots);
         if (num_read != 1)
             status = DECRYPTION_TRUSTEE_IO_ERROR;
     }
@@ -231,17 +492,77 @@ Decryption_Trustee_tally_voting_record(Decryption_Trustee decryption_trustee, FI
             status = DECRYPTION_TRUSTEE_MALFORMED_INPUT;
     }
 
+    return status;
+}
+
+static enum Decryption_Trustee_status
+Decryption_Trustee_ballot_record_status_convert(enum Ballot_Record_status status)
+{
+    switch (status)
+    {
+    case BALLOT_RECORD_SUCCESS:
+        return DECRYPTION_TRUSTEE_SUCCESS;
+    case BALLOT_RECORD_INSUFFICIENT_MEMORY:
+        return DECRYPTION_TRUSTEE_INSUFFICIENT_MEMORY;
+    case BALLOT_RECORD_MALFORMED:
+        return DECRYPTION_TRUSTEE_MALFORMED_INPUT;
+    default:
+        return DECRYPTION_TRUSTEE_IO_ERROR;
+    }
+}
+
+// Map a binary voting record and check it is for this trustee's election
+static enum Decryption_Trustee_status
+Decryption_Trustee_open_record(Decryption_Trustee decryption_trustee, FILE *in,
+                               struct ballot_record *record)
+{
+    enum Decryption_Trustee_status status =
+        Decryption_Trustee_ballot_record_status_convert(
+            Ballot_Record_open(record, in));
+
+    if (status == DECRYPTION_TRUSTEE_SUCCESS &&
+        record->header.num_selections != decryption_trustee->num_selections)
+    {
+        Ballot_Record_close(record);
+        status = DECRYPTION_TRUSTEE_MALFORMED_INPUT;
+    }
+
+    return status;
+}
+
+static enum Decryption_Trustee_status
+Decryption_Trustee_tally_binary_voting_record(
+    Decryption_Trustee decryption_trustee, FILE *in);
+
+enum Decryption_Trustee_status
+Decryption_Trustee_tally_voting_record(Decryption_Trustee decryption_trustee, FILE *in)
+{
+    if (Ballot_Record_is_binary(in))
+        return Decryption_Trustee_tally_binary_voting_record(
+            decryption_trustee, in);
+
+    uint64_t num_ballots;
+    enum Decryption_Trustee_status status =
+        Decryption_Trustee_read_header(decryption_trustee, in, &num_ballots);
+
+    struct encryption_slots_sum tally;
+    struct encryption_slots slots;
+    {
+        enum Decryption_Trustee_status tally_status =
+            Decryption_Trustee_new_tally(decryption_trustee, &tally, &slots);
+        if (status == DECRYPTION_TRUSTEE_SUCCESS)
+            status = tally_status;
+    }
+
+    struct encryption_rep selections[MAX_SELECTIONS];
+    for (uint32_t j = 0; j < decryption_trustee->num_selections; j++)
+        Crypto_encryption_rep_new(&selections[j]);
+
     for (size_t i = 0; i < num_ballots && status == DECRYPTION_TRUSTEE_SUCCESS;
          i++)
     {
         uint64_t ballot_id;
         bool cast;
-        struct encryption_rep selections[MAX_SELECTIONS];
-
-        for (int j = 0; j < decryption_trustee->num_selections; j++)
-        {
-            Crypto_encryption_rep_new(&selections[j]);
-        }
 
         status = Decryption_Trustee_read_ballot(
             in,
@@ -253,18 +574,331 @@ Decryption_Trustee_tally_voting_record(Decryption_Trustee decryption_trustee, FI
 
         if (status == DECRYPTION_TRUSTEE_SUCCESS && cast)
         {
-            Decryption_Trustee_accum_tally(decryption_trustee, selections);
+            status = Decryption_Trustee_accum_tally(&tally, &slots, selections);
+        }
+    }
+
+    for (uint32_t j = 0; j < decryption_trustee->num_selections; j++)
+        Crypto_encryption_rep_free(&selections[j]);
+    Crypto_encryption_slots_free(&slots);
+
+    Decryption_Trustee_combine_tally(decryption_trustee, &tally, num_ballots,
+                                     status == DECRYPTION_TRUSTEE_SUCCESS);
+
+    return status;
+}
+
+// The ballots whose lines start in [begin, end) of a voting record, or for
+// a binary record the records numbered [begin, end), tallied on their own
+// thread into a partial tally
+struct Decryption_Trustee_shard
+{
+    Decryption_Trustee decryption_trustee;
+    const char *filename;
+    const struct ballot_record *record;
+    int64_t begin;
+    int64_t end;
+    bool first;
+    bool started;
+    enum Decryption_Trustee_status status;
+    uint64_t num_ballots;
+    struct encryption_slots_sum tally;
+};
+
+// Tally a shard of a binary record, which needs no parsing, straight from
+// the slots of its records
+static void
+Decryption_Trustee_tally_record_shard(struct Decryption_Trustee_shard *shard)
+{
+    struct encryption_slots slots;
+    shard->status = Decryption_Trustee_new_tally(shard->decryption_trustee,
+                                                 &shard->tally, &slots);
+
+    for (int64_t i = shard->begin;
+         i < shard->end && shard->status == DECRYPTION_TRUSTEE_SUCCESS; i++)
+    {
+        shard->num_ballots++;
+        if (Ballot_Record_cast(shard->record, i))
+        {
+            Ballot_Record_selection_slots(shard->record, i, &slots);
+            Crypto_encryption_slots_sum_add(&shard->tally, &slots);
+        }
+    }
+
+    Crypto_encryption_slots_free(&slots);
+}
+
+static void *Decryption_Trustee_tally_shard(void *arg)
+{
+    struct Decryption_Trustee_shard *shard = arg;
+    const uint32_t num_selections = shard->decryption_trustee->num_selections;
+
+    shard->status = DECRYPTION_TRUSTEE_SUCCESS;
+    shard->num_ballots = 0;
+
+    if (shard->record != NULL)
+    {
+        Decryption_Trustee_tally_record_shard(shard);
+        return NULL;
+    }
+
+    FILE *in = fopen(shard->filename, "rb");
+    if (in == NULL)
+        shard->status = DECRYPTION_TRUSTEE_IO_ERROR;
+
+    // Skip the end of the line that straddles the start of the shard; it
+    // belongs to the previous one. The first shard starts on a line.
+    if (shard->status == DECRYPTION_TRUSTEE_SUCCESS)
+    {
+        if (0 != fseeko(in, shard->first ? shard->begin : shard->begin - 1,
+                        SEEK_SET))
+            shard->status = DECRYPTION_TRUSTEE_IO_ERROR;
+    }
+
+    if (shard->status == DECRYPTION_TRUSTEE_SUCCESS && !shard->first)
+    {
+        int c;
+        do
+            c = fgetc(in);
+        while (c != '\n' && c != EOF);
+    }
+
+    struct encryption_slots slots;
+    {
+        enum Decryption_Trustee_status tally_status =
+            Decryption_Trustee_new_tally(shard->decryption_trustee,
+                                         &shard->tally, &slots);
+        if (shard->status == DECRYPTION_TRUSTEE_SUCCESS)
+            shard->status = tally_status;
+    }
+
+    struct encryption_rep selections[MAX_SELECTIONS];
+    for (uint32_t j = 0; j < num_selections; j++)
+        Crypto_encryption_rep_new(&selections[j]);
+
+    while (shard->status == DECRYPTION_TRUSTEE_SUCCESS)
+    {
+        int64_t position = ftello(in);
+        int c = fgetc(in);
+        if (position < 0 || position >= shard->end || c == EOF)
+            break;
+        ungetc(c, in);
+
+        uint64_t ballot_id;
+        bool cast;
+        shard->status = Decryption_Trustee_read_ballot(
+            in, &ballot_id, &cast, num_selections, selections);
+
+        if (shard->status == DECRYPTION_TRUSTEE_SUCCESS)
+        {
+            shard->num_ballots++;
+            if (cast)
+                shard->status = Decryption_Trustee_accum_tally(
+                    &shard->tally, &slots, selections);
+        }
+
+        // Move to the start of the next line
+        do
+            c = fgetc(in);
+        while (c != '\n' && c != EOF);
+    }
+
+    for (uint32_t j = 0; j < num_selections; j++)
+        Crypto_encryption_rep_free(&selections[j]);
+    Crypto_encryption_slots_free(&slots);
+
+    if (in != NULL)
+        fclose(in);
+
+    return NULL;
+}
+
+enum Decryption_Trustee_status
+Decryption_Trustee_tally_voting_record_sharded(
+    Decryption_Trustee decryption_trustee, const char *filename,
+    uint32_t num_shards)
+{
+    enum Decryption_Trustee_status status = DECRYPTION_TRUSTEE_SUCCESS;
+
+    if (num_shards == 0)
+        num_shards = 1;
+
+    // Find the ballots: everything after the header. Binary records are
+    // split by record rather than by byte, and share one map of the file
+    uint64_t num_ballots = 0;
+    int64_t ballots_begin = 0, ballots_end = 0;
+    bool binary = false;
+    struct ballot_record record;
+    FILE *in = fopen(filename, "rb");
+    if (in == NULL)
+        status = DECRYPTION_TRUSTEE_IO_ERROR;
+    else
+        binary = Ballot_Record_is_binary(in);
+
+    if (status == DECRYPTION_TRUSTEE_SUCCESS && binary)
+    {
+        status = Decryption_Trustee_open_record(decryption_trustee, in, &record);
+        if (status == DECRYPTION_TRUSTEE_SUCCESS)
+        {
+            num_ballots = record.header.num_records;
+            ballots_end = (int64_t)num_ballots;
         }
+        else
+            binary = false;
+    }
+    else if (status == DECRYPTION_TRUSTEE_SUCCESS)
+    {
+        status = Decryption_Trustee_read_header(decryption_trustee, in,
+                                                &num_ballots);
 
-        for (int j = 0; j < decryption_trustee->num_selections; j++)
+        if (status == DECRYPTION_TRUSTEE_SUCCESS)
         {
-            Crypto_encryption_rep_free(&selections[j]);
+            ballots_begin = ftello(in);
+            if (ballots_begin < 0 || 0 != fseeko(in, 0, SEEK_END))
+                status = DECRYPTION_TRUSTEE_IO_ERROR;
+            else
+                ballots_end = ftello(in);
         }
     }
 
+    if (in != NULL)
+        fclose(in);
+
+    // Don't bother with more shards than ballots
+    if (num_shards > num_ballots && num_ballots > 0)
+        num_shards = (uint32_t)num_ballots;
+
+    struct Decryption_Trustee_shard *shards = NULL;
+    pthread_t *threads = NULL;
+    if (status == DECRYPTION_TRUSTEE_SUCCESS)
+    {
+        shards = malloc(num_shards * sizeof(struct Decryption_Trustee_shard));
+        threads = malloc(num_shards * sizeof(pthread_t));
+        if (shards == NULL || threads == NULL)
+            status = DECRYPTION_TRUSTEE_INSUFFICIENT_MEMORY;
+    }
+
+    if (status == DECRYPTION_TRUSTEE_SUCCESS)
+    {
+        const int64_t length = ballots_end - ballots_begin;
+        for (uint32_t k = 0; k < num_shards; k++)
+        {
+            shards[k] = (struct Decryption_Trustee_shard){
+                .decryption_trustee = decryption_trustee,
+                .filename = filename,
+                .record = binary ? &record : NULL,
+                .begin = ballots_begin + length * k / num_shards,
+                .end = ballots_begin + length * (k + 1) / num_shards,
+                .first = k == 0,
+            };
+        }
+
+        // The first shard is tallied on this thread, as is any shard
+        // whose thread could not be started
+        for (uint32_t k = 1; k < num_shards; k++)
+            shards[k].started =
+                0 == pthread_create(&threads[k], NULL,
+                                    Decryption_Trustee_tally_shard, &shards[k]);
+
+        for (uint32_t k = 0; k < num_shards; k++)
+            if (!shards[k].started)
+                Decryption_Trustee_tally_shard(&shards[k]);
+
+        for (uint32_t k = 1; k < num_shards; k++)
+            if (shards[k].started)
+                pthread_join(threads[k], NULL);
+
+        uint64_t num_tallied = 0;
+        for (uint32_t k = 0; k < num_shards; k++)
+        {
+            if (status == DECRYPTION_TRUSTEE_SUCCESS)
+                status = shards[k].status;
+            num_tallied += shards[k].num_ballots;
+        }
+        if (status == DECRYPTION_TRUSTEE_SUCCESS && num_tallied != num_ballots)
+            status = DECRYPTION_TRUSTEE_MALFORMED_INPUT;
+
+        // Combine the partial tallies
+        for (uint32_t k = 0; k < num_shards; k++)
+            Decryption_Trustee_combine_tally(
+                decryption_trustee, &shards[k].tally, shards[k].num_ballots,
+                status == DECRYPTION_TRUSTEE_SUCCESS);
+    }
+
+    free(shards);
+    free(threads);
+
+    if (binary)
+        Ballot_Record_close(&record);
+
     return status;
 }
 
+static enum Decryption_Trustee_status
+Decryption_Trustee_tally_binary_voting_record(
+    Decryption_Trustee decryption_trustee, FILE *in)
+{
+    struct ballot_record record;
+    enum Decryption_Trustee_status status =
+        Decryption_Trustee_open_record(decryption_trustee, in, &record);
+
+    if (status == DECRYPTION_TRUSTEE_SUCCESS)
+    {
+        struct Decryption_Trustee_shard *shard =
+            malloc(sizeof(struct Decryption_Trustee_shard));
+        if (shard == NULL)
+            status = DECRYPTION_TRUSTEE_INSUFFICIENT_MEMORY;
+        else
+        {
+            *shard = (struct Decryption_Trustee_shard){
+                .decryption_trustee = decryption_trustee,
+                .record = &record,
+                .begin = 0,
+                .end = (int64_t)record.header.num_records,
+            };
+            Decryption_Trustee_tally_record_shard(shard);
+            status = shard->status;
+            Decryption_Trustee_combine_tally(
+                decryption_trustee, &shard->tally, shard->num_ballots,
+                status == DECRYPTION_TRUSTEE_SUCCESS);
+            free(shard);
+        }
+
+        Ballot_Record_close(&record);
+    }
+
+    return status;
+}
+
+enum Decryption_Trustee_status
+Decryption_Trustee_copy_tally(Decryption_Trustee decryption_trustee,
+                              Decryption_Trustee source)
+{
+    enum Decryption_Trustee_status status = DECRYPTION_TRUSTEE_SUCCESS;
+
+    if (decryption_trustee->num_selections != source->num_selections)
+        status = DECRYPTION_TRUSTEE_INVALID_PARAMS;
+
+    for (uint32_t i = 0;
+         i < decryption_trustee->num_selections &&
+         status == DECRYPTION_TRUSTEE_SUCCESS;
+         i++)
+    {
+        Crypto_encryption_rep_copy(&decryption_trustee->tallies[i],
+                                   &source->tallies[i]);
+    }
+
+    if (status == DECRYPTION_TRUSTEE_SUCCESS)
+        decryption_trustee->num_ballots = source->num_ballots;
+
+    return status;
+}
+
+uint64_t Decryption_Trustee_num_ballots(Decryption_Trustee decryption_trustee)
+{
+    return decryption_trustee->num_ballots;
+}
+
 struct Decryption_Trustee_compute_share_r
 Decryption_Trustee_compute_share(Decryption_Trustee decryption_trustee)
 {
@@ -290,17 +924,15 @@ Decryption_Trustee_compute_share(Decryption_Trustee decryption_trustee)
             Crypto_generate_decryption_cp_proof(
                 &share_rep.cp_proofs[i], decryption_trustee->private_key.coefficients[0],
                 share_rep.tally_share[i].nonce_encoding, decryption_trustee->tallies[i],
-                decryption_trustee->base_hash);
-
-            //Reconstruct the public key to sanity check the proof
-            mpz_t public_key;
-            mpz_init(public_key);
-            pow_mod_p(public_key, generator, decryption_trustee->private_key.coefficients[0]);
-            Crypto_check_decryption_cp_proof(
-                share_rep.cp_proofs[i], public_key,
-                share_rep.tally_share[i].nonce_encoding, decryption_trustee->tallies[i],
-                decryption_trustee->base_hash);
-            mpz_clear(public_key);
+                decryption_trustee->base_hash, &decryption_trustee->bases);
+
+            //Sanity check the proof against our public key
+            if (result.status == DECRYPTION_TRUSTEE_SUCCESS)
+                result.status = Decryption_Trustee_verify_proof(
+                    decryption_trustee, &share_rep.cp_proofs[i],
+                    share_rep.tally_share[i].nonce_encoding,
+                    &decryption_trustee->tallies[i], decryption_trustee->index,
+                    NULL);
         }
 
         //printf("Trustee %d sending 0th\n", d->index);
@@ -319,7 +951,9 @@ Decryption_Trustee_compute_share(Decryption_Trustee decryption_trustee)
         Serialize_allocate(&state);
         Serialize_write_decryption_share(&state, &share_rep);
 
-        if (state.status != SERIALIZE_STATE_WRITING)
+        if (result.status != DECRYPTION_TRUSTEE_SUCCESS)
+            free(state.buf);
+        else if (state.status != SERIALIZE_STATE_WRITING)
             result.status = DECRYPTION_TRUSTEE_SERIALIZE_ERROR;
         else
         {
@@ -493,14 +1127,14 @@ Decryption_Trustee_compute_fragments(Decryption_Trustee decryption_trustee,
                         origin,
                         decryption_fragments_rep.partial_decryption_M[i][j], 
                         decryption_trustee->tallies[j],
-                        decryption_trustee->base_hash);
-                    pow_mod_p(origin, generator, origin);
-                    Crypto_check_decryption_cp_proof(
-                        decryption_fragments_rep.cp_proofs[i][j], 
-                        origin,
-                        decryption_fragments_rep.partial_decryption_M[i][j], 
-                        decryption_trustee->tallies[j],
-                        decryption_trustee->base_hash);
+                        decryption_trustee->base_hash,
+                        &decryption_trustee->bases);
+                    if (result.status == DECRYPTION_TRUSTEE_SUCCESS)
+                        result.status = Decryption_Trustee_verify_proof(
+                            decryption_trustee,
+                            &decryption_fragments_rep.cp_proofs[i][j],
+                            decryption_fragments_rep.partial_decryption_M[i][j],
+                            &decryption_trustee->tallies[j], i, origin);
                     mpz_clear(origin);
                 }
         }
@@ -518,7 +1152,9 @@ Decryption_Trustee_compute_fragments(Decryption_Trustee decryption_trustee,
         Serialize_allocate(&state);
         Serialize_write_decryption_fragments(&state, &decryption_fragments_rep);
 
-        if (state.status != SERIALIZE_STATE_WRITING)
+        if (result.status != DECRYPTION_TRUSTEE_SUCCESS)
+            free(state.buf);
+        else if (state.status != SERIALIZE_STATE_WRITING)
             result.status = DECRYPTION_TRUSTEE_SERIALIZE_ERROR;
         else
         {
@@ -128,7 +128,9 @@ KeyCeremony_Trustee_generate_key(KeyCeremony_Trustee t, raw_hash base_hash_code)
     };
 
     // Generate the RSA keys
-    generate_keys(&t->rsa_private_key, &t->rsa_public_key);
+    if (result.status == KEYCEREMONY_TRUSTEE_SUCCESS &&
+        !generate_keys(&t->rsa_private_key, &t->rsa_public_key))
+        result.status = KEYCEREMONY_TRUSTEE_IO_ERROR;
 
     if (result.status == KEYCEREMONY_TRUSTEE_SUCCESS)
     {
@@ -0,0 +1,9 @@
+#ifndef __PROCESSORS_H__
+#define __PROCESSORS_H__
+
+#include <stdint.h>
+
+/** The number of processors online, and at least 1. */
+uint32_t Processors_count(void);
+
+#endif /* __PROCESSORS_H__ */
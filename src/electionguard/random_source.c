@@ -1,6 +1,7 @@
 #include "random_source.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "bignum.h"
 
 #ifdef HAVE_BCRYPTGENRANDOM
@@ -8,8 +9,23 @@
 #include <assert.h>
 #include <ntstatus.h>
 #include <bcrypt.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#ifdef HAVE_GETRANDOM
+#include <sys/random.h>
+#endif
 #endif
 
+// ChaCha20 blocks generated per refill of the buffer
+#define RANDOM_SOURCE_BLOCKS 16
+#define RANDOM_SOURCE_BLOCK_SIZE 64
+#define RANDOM_SOURCE_KEY_SIZE 32
+#define RANDOM_SOURCE_BUFFER_SIZE                                              \
+    (RANDOM_SOURCE_BLOCKS * RANDOM_SOURCE_BLOCK_SIZE)
+// Bytes handed out between mixing fresh bytes from the system into the key
+#define RANDOM_SOURCE_RESEED_INTERVAL (1 << 20)
+
 struct RandomSource_s
 {
 #ifdef HAVE_BCRYPTGENRANDOM
@@ -18,10 +34,187 @@ struct RandomSource_s
 //   https://docs.microsoft.com/en-us/windows/win32/api/bcrypt/nf-bcrypt-bcryptopenalgorithmprovider
 // For the time being we are using the Windows' default RNG algorithm.
 #else
+#ifndef HAVE_GETRANDOM
     FILE *dev_random;
 #endif
+    // The number of forks the process had seen when last seeded
+    uint64_t forks;
+#endif
+    uint32_t key[RANDOM_SOURCE_KEY_SIZE / 4];
+    // Keystream not yet handed out is buffer[position..]
+    uint8_t buffer[RANDOM_SOURCE_BUFFER_SIZE];
+    size_t position;
+    uint64_t since_reseed;
 };
 
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QUARTER_ROUND(a, b, c, d)                                              \
+    do                                                                         \
+    {                                                                          \
+        a += b, d ^= a, d = ROTL32(d, 16);                                     \
+        c += d, b ^= c, b = ROTL32(b, 12);                                     \
+        a += b, d ^= a, d = ROTL32(d, 8);                                      \
+        c += d, b ^= c, b = ROTL32(b, 7);                                      \
+    } while (0)
+
+// Block number counter of the ChaCha20 keystream for key, with a zero nonce
+static void RandomSource_chacha20_block(const uint32_t *key, uint64_t counter,
+                                        uint8_t *out)
+{
+    uint32_t input[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    for (int i = 0; i < 8; i++)
+        input[4 + i] = key[i];
+    input[12] = (uint32_t)counter;
+    input[13] = (uint32_t)(counter >> 32);
+
+    uint32_t x[16];
+    memcpy(x, input, sizeof(x));
+    for (int i = 0; i < 10; i++)
+    {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        uint32_t word = x[i] + input[i];
+        for (int j = 0; j < 4; j++)
+            out[4 * i + j] = (uint8_t)(word >> (8 * j));
+    }
+}
+
+#ifndef HAVE_BCRYPTGENRANDOM
+// Counts the forks of the process, in the child, so that a generator copied
+// into it can tell it must not carry on the parent's stream
+static volatile uint64_t random_source_forks;
+static pthread_once_t random_source_forks_once = PTHREAD_ONCE_INIT;
+
+static void RandomSource_count_fork(void) { random_source_forks++; }
+
+static void RandomSource_count_forks(void)
+{
+    pthread_atfork(NULL, NULL, RandomSource_count_fork);
+}
+#endif
+
+// len bytes straight from the operating system
+static enum RandomSource_status
+RandomSource_system_bytes(RandomSource source, uint8_t *out, size_t len)
+{
+    (void)source;
+#ifdef HAVE_BCRYPTGENRANDOM
+    NTSTATUS ntstatus =
+        BCryptGenRandom(NULL, out, (ULONG)len, BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+    if (ntstatus != STATUS_SUCCESS)
+        return RANDOM_SOURCE_IO_ERROR;
+#elif defined(HAVE_GETRANDOM)
+    while (len > 0)
+    {
+        ssize_t count = getrandom(out, len, 0);
+        if (count < 0 && errno != EINTR)
+            return RANDOM_SOURCE_IO_ERROR;
+        if (count > 0)
+            out += count, len -= (size_t)count;
+    }
+#else
+    if (1 != fread(out, len, 1, source->dev_random))
+        return RANDOM_SOURCE_IO_ERROR;
+#endif
+    return RANDOM_SOURCE_SUCCESS;
+}
+
+// Mix fresh bytes from the system into the key, and drop the buffer
+static enum RandomSource_status RandomSource_reseed(RandomSource source)
+{
+    uint8_t seed[RANDOM_SOURCE_KEY_SIZE];
+    enum RandomSource_status status =
+        RandomSource_system_bytes(source, seed, sizeof(seed));
+
+    if (RANDOM_SOURCE_SUCCESS == status)
+    {
+        for (int i = 0; i < RANDOM_SOURCE_KEY_SIZE / 4; i++)
+            source->key[i] ^= (uint32_t)seed[4 * i] |
+                              (uint32_t)seed[4 * i + 1] << 8 |
+                              (uint32_t)seed[4 * i + 2] << 16 |
+                              (uint32_t)seed[4 * i + 3] << 24;
+
+        source->position = RANDOM_SOURCE_BUFFER_SIZE;
+        source->since_reseed = 0;
+#ifndef HAVE_BCRYPTGENRANDOM
+        source->forks = random_source_forks;
+#endif
+    }
+
+    memset(seed, 0, sizeof(seed));
+    return status;
+}
+
+// Fill the buffer with keystream, taking the next key from its start
+static enum RandomSource_status RandomSource_refill(RandomSource source)
+{
+    enum RandomSource_status status = RANDOM_SOURCE_SUCCESS;
+
+    if (source->since_reseed >= RANDOM_SOURCE_RESEED_INTERVAL)
+        status = RandomSource_reseed(source);
+
+    if (RANDOM_SOURCE_SUCCESS == status)
+    {
+        for (uint64_t i = 0; i < RANDOM_SOURCE_BLOCKS; i++)
+            RandomSource_chacha20_block(
+                source->key, i, source->buffer + i * RANDOM_SOURCE_BLOCK_SIZE);
+
+        for (int i = 0; i < RANDOM_SOURCE_KEY_SIZE / 4; i++)
+            source->key[i] = (uint32_t)source->buffer[4 * i] |
+                             (uint32_t)source->buffer[4 * i + 1] << 8 |
+                             (uint32_t)source->buffer[4 * i + 2] << 16 |
+                             (uint32_t)source->buffer[4 * i + 3] << 24;
+        memset(source->buffer, 0, RANDOM_SOURCE_KEY_SIZE);
+        source->position = RANDOM_SOURCE_KEY_SIZE;
+    }
+
+    return status;
+}
+
+enum RandomSource_status RandomSource_fill(RandomSource source, uint8_t *out,
+                                           size_t len)
+{
+    enum RandomSource_status status = RANDOM_SOURCE_SUCCESS;
+
+    // A forked child must not hand out what is left of its parent's stream
+#ifndef HAVE_BCRYPTGENRANDOM
+    if (source->forks != random_source_forks)
+        status = RandomSource_reseed(source);
+#endif
+
+    while (len > 0 && RANDOM_SOURCE_SUCCESS == status)
+    {
+        if (source->position == RANDOM_SOURCE_BUFFER_SIZE)
+            status = RandomSource_refill(source);
+
+        if (RANDOM_SOURCE_SUCCESS == status)
+        {
+            size_t count = RANDOM_SOURCE_BUFFER_SIZE - source->position;
+            if (count > len)
+                count = len;
+
+            // Bytes are wiped as they are handed out
+            memcpy(out, source->buffer + source->position, count);
+            memset(source->buffer + source->position, 0, count);
+            source->position += count;
+            source->since_reseed += count;
+            out += count, len -= count;
+        }
+    }
+
+    return status;
+}
+
 struct RandomSource_new_r RandomSource_new(void)
 {
     struct RandomSource_new_r result;
@@ -34,42 +227,48 @@ struct RandomSource_new_r RandomSource_new(void)
 
     if (RANDOM_SOURCE_SUCCESS == result.status)
     {
-#ifdef HAVE_BCRYPTGENRANDOM
-        //For Windows, we dont need to do anything particular here
-#else
-        result.source->dev_random = fopen("/dev/urandom", "r");
-        if (NULL == result.source->dev_random)
+        memset(result.source->key, 0, sizeof(result.source->key));
+#ifndef HAVE_BCRYPTGENRANDOM
+        pthread_once(&random_source_forks_once, RandomSource_count_forks);
+#endif
+#if !defined(HAVE_BCRYPTGENRANDOM) && !defined(HAVE_GETRANDOM)
+        result.source->dev_random = fopen("/dev/urandom", "rb");
+        // Unbuffered, since children forked from one parent would share a
+        // stdio buffer and all reseed from the same bytes
+        if (NULL == result.source->dev_random ||
+            0 != setvbuf(result.source->dev_random, NULL, _IONBF, 0))
         {
+            if (NULL != result.source->dev_random)
+                fclose(result.source->dev_random);
             result.status = RANDOM_SOURCE_IO_ERROR;
             free(result.source);
         }
 #endif
     }
 
+    if (RANDOM_SOURCE_SUCCESS == result.status)
+    {
+        result.status = RandomSource_reseed(result.source);
+        if (RANDOM_SOURCE_SUCCESS != result.status)
+            RandomSource_free(result.source);
+    }
+
     return result;
 }
 
 void RandomSource_free(RandomSource source)
 {
-#ifdef HAVE_BCRYPTGENRANDOM
-    free(source);
-#else
+#if !defined(HAVE_BCRYPTGENRANDOM) && !defined(HAVE_GETRANDOM)
     fclose(source->dev_random);
-    free(source);
 #endif
+    memset(source, 0, sizeof(*source));
+    free(source);
 }
 
 uint8_t RandomSource_get_byte(RandomSource source)
 {
-    size_t item_count;
-    uint8_t ret;
-#ifdef HAVE_BCRYPTGENRANDOM
-    NTSTATUS ntstatus =
-        BCryptGenRandom(NULL, &ret, 1, BCRYPT_USE_SYSTEM_PREFERRED_RNG);
-    assert(ntstatus == STATUS_SUCCESS);
-#else
-    fread(&ret, 1, 1, source->dev_random);
-#endif
+    uint8_t ret = 0;
+    RandomSource_fill(source, &ret, 1);
     return ret;
 }
 
@@ -77,7 +276,6 @@ enum RandomSource_status RandomSource_uniform_o(RandomSource source,
                                                 uint4096 out)
 {
     uint8_t raw_bytes[UINT4096_SIZE_BYTES];
-    size_t item_count;
     enum RandomSource_status result = RANDOM_SOURCE_SUCCESS;
     struct uint4096_s zero;
     uint4096_zext_o(&zero, NULL, 0);
@@ -86,22 +284,7 @@ enum RandomSource_status RandomSource_uniform_o(RandomSource source,
     {
         if (RANDOM_SOURCE_SUCCESS == result)
         {
-#ifdef HAVE_BCRYPTGENRANDOM
-            NTSTATUS ntstatus =
-                BCryptGenRandom(NULL, raw_bytes, UINT4096_SIZE_BYTES,
-                                BCRYPT_USE_SYSTEM_PREFERRED_RNG);
-            if (ntstatus != STATUS_SUCCESS)
-            {
-                result = RANDOM_SOURCE_IO_ERROR;
-            }
-#else
-            item_count =
-                fread(raw_bytes, UINT4096_SIZE_BYTES, 1, source->dev_random);
-            if (1 != item_count)
-            {
-                result = RANDOM_SOURCE_IO_ERROR;
-            }
-#endif
+            result = RandomSource_fill(source, raw_bytes, UINT4096_SIZE_BYTES);
         }
 
         if (RANDOM_SOURCE_SUCCESS == result)
@@ -151,43 +334,25 @@ enum RandomSource_status RandomSource_uniform_bignum_o(mpz_t out,
     return result.status;
 }
 
-// Random uniform bignum from 1 to q
+// Random uniform bignum from 0 to q - 1
 enum RandomSource_status RandomSource_uniform_bignum_o_q(mpz_t out,
                                                        RandomSource source)
 {
     uint8_t raw_bytes[32];
-    size_t item_count;
     enum RandomSource_status result = RANDOM_SOURCE_SUCCESS;
 
     do
     {
         if (RANDOM_SOURCE_SUCCESS == result)
         {
-#ifdef HAVE_BCRYPTGENRANDOM
-            NTSTATUS ntstatus =
-                BCryptGenRandom(NULL, raw_bytes, 32,
-                                BCRYPT_USE_SYSTEM_PREFERRED_RNG);
-            if (ntstatus != STATUS_SUCCESS)
-            {
-                result = RANDOM_SOURCE_IO_ERROR;
-            }
-#else
-            item_count =
-                fread(raw_bytes, 32, 1, source->dev_random);
-            if (1 != item_count)
-            {
-                result = RANDOM_SOURCE_IO_ERROR;
-            }
-#endif
+            result = RandomSource_fill(source, raw_bytes, 32);
         }
 
         if (RANDOM_SOURCE_SUCCESS == result)
         {
             mpz_import(out, 32, 1, 1, 0, 0, raw_bytes);
         }
-    } while (RANDOM_SOURCE_SUCCESS == result &&
-             (mpz_cmp_ui(out, 0) == -1 ||
-              mpz_cmp(out, q) == 1));
+    } while (RANDOM_SOURCE_SUCCESS == result && mpz_cmp(out, q) >= 0);
 
     return result;
 }
@@ -13,33 +13,35 @@
  **********************************************************************/
 #include <gmp.h>
 #include <assert.h>
+#include <stdbool.h>
 #include <time.h>
 #include <stdint.h>
 #include "electionguard/rsa.h"
 #include "random_source.h"
 
 /* Assumes mpz_t's are initted in priv_key and pub_key */
-void generate_keys(rsa_private_key* priv_key, rsa_public_key* pub_key)
+bool generate_keys(rsa_private_key* priv_key, rsa_public_key* pub_key)
 {
     uint8_t buffer[BUFFER_SIZE];
-    mpz_t lambda, gcd, tmp1, tmp2;
-    mpz_inits(gcd,tmp1, tmp2, lambda, NULL);
-    mpz_t u_1, u_2;
-    mpz_init(u_1);
-    mpz_init(u_2);
 
     RandomSource source;
     struct RandomSource_new_r source_r = RandomSource_new();
+    if (source_r.status != RANDOM_SOURCE_SUCCESS)
+        return false;
     source = source_r.source;
 
-    mpz_set_ui(priv_key->e, 3);
-
-    /* Select p */
-    for(int i = 0; i < BUFFER_SIZE; i++)
+    /* Select p, but not from a buffer the source failed to fill */
+    if (RandomSource_fill(source, buffer, BUFFER_SIZE) != RANDOM_SOURCE_SUCCESS)
     {
-        buffer[i] = RandomSource_get_byte(source);
+        RandomSource_free(source);
+        return false;
     }
 
+    mpz_t lambda, gcd, tmp1, tmp2;
+    mpz_inits(gcd,tmp1, tmp2, lambda, NULL);
+
+    mpz_set_ui(priv_key->e, 3);
+
     buffer[0] |= 0xC0;                                  // Set the top two bits to 1 to ensure int(tmp) is relatively large
     buffer[BUFFER_SIZE - 1] |= 0x01;                    // Set the bottom bit to 1 to ensure int  is odd
     mpz_import(tmp1, BUFFER_SIZE, 1, sizeof(buffer[0]), 0, 0, buffer);
@@ -53,13 +55,12 @@ void generate_keys(rsa_private_key* priv_key, rsa_public_key* pub_key)
 
 
     /* Select q */
+    bool ok = true;
     do {
-        for(int i = 0; i < BUFFER_SIZE; i++)
+        if (RandomSource_fill(source, buffer, BUFFER_SIZE) != RANDOM_SOURCE_SUCCESS)
         {
-            RandomSource_uniform_bignum_o(u_2, source);
-            buffer[i] = mpz_get_ui(u_2) % 0xFF;
-            mpz_clear(u_2);
-            mpz_init(u_2);
+            ok = false;
+            break;
         }
 
         buffer[0] |= 0xC0;                              // Set the top two bits to 1 to ensure int(tmp) is relatively large
@@ -75,6 +76,13 @@ void generate_keys(rsa_private_key* priv_key, rsa_public_key* pub_key)
         }
     } while(mpz_cmp(priv_key->p, priv_key->q) == 0);    // If we have identical primes (unlikely), try again
 
+    if (!ok)
+    {
+        mpz_clears(lambda, tmp1, tmp2, gcd, NULL);
+        RandomSource_free(source);
+        return false;
+    }
+
     mpz_mul(priv_key->n, priv_key->p, priv_key->q);     // Calculate n = pq
 
     mpz_sub_ui(tmp1, priv_key->p, 1);
@@ -90,8 +98,9 @@ void generate_keys(rsa_private_key* priv_key, rsa_public_key* pub_key)
 
     mpz_set(pub_key->e, priv_key->e);                   // Set public key
     mpz_set(pub_key->n, priv_key->n);
-    mpz_clears(lambda, tmp1, tmp2, gcd, u_1, u_2, NULL);
+    mpz_clears(lambda, tmp1, tmp2, gcd, NULL);
     RandomSource_free(source);
+    return true;
 }
 /* Assumes mpz_t encrypted, mpz_t message, public_key pub_key are initialized */
 void RSA_Encrypt(mpz_t encrypted, mpz_t message, rsa_public_key* pub_key)
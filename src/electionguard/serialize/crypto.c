@@ -100,6 +100,11 @@ void Serialize_write_uint4096(struct serialize_state *state, const mpz_t data)
     Serialize_write_uint64_ts(state, data, UINT4096_WORD_COUNT);
 }
 
+void Serialize_write_uint4096_pad(struct serialize_state *state, const mpz_t data)
+{
+    Serialize_write_uint64_ts_pad(state, data, UINT4096_WORD_COUNT);
+}
+
 void Serialize_read_uint4096(struct serialize_state *state, mpz_t data)
 {
     uint4096 tmp = malloc(sizeof(struct uint4096_s));
@@ -236,9 +241,10 @@ void Serialize_write_private_key(struct serialize_state *state,
                                  struct private_key const *data)
 {
     Serialize_write_uint32(state, &data->threshold);
+    // The coefficients are mod q, and so usually shorter than 4096 bits
     for (uint32_t i = 0; i < data->threshold; i++)
     {
-        Serialize_write_uint4096(state, data->coefficients[i]);
+        Serialize_write_uint4096_pad(state, data->coefficients[i]);
     }
 }
 
@@ -19,6 +19,7 @@ void Serialize_reserve_uint4096(struct serialize_state *state,
                                 const_uint4096 data);
 
 void Serialize_write_uint4096(struct serialize_state *state, const mpz_t data);
+void Serialize_write_uint4096_pad(struct serialize_state *state, const mpz_t data);
 
 void Serialize_read_uint4096(struct serialize_state *state, mpz_t data);
 
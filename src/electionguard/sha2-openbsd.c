@@ -39,6 +39,7 @@
 //#include <crypto/sha2.h>
 
 #include "sha2-openbsd.h"
+#include "sha256_accel.h"
 
 #ifdef NO_MEMSET_S
 // See https://llvm.org/bugs/show_bug.cgi?id=15495
@@ -175,6 +176,7 @@ void force_memset(void *ptr, size_t len) {
  */
 void SHA512Last(SHA2_CTX *);
 void SHA256Transform(SHA2_CTX *, const uint8_t *);
+static void SHA256Transform_blocks(SHA2_CTX *, const uint8_t *, size_t);
 void SHA512Transform(SHA2_CTX *, const uint8_t *);
 
 
@@ -458,6 +460,16 @@ SHA256Transform(SHA2_CTX *context, const uint8_t *data)
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+/* Process num_blocks blocks with the SHA instructions, if there are any */
+static void
+SHA256Transform_blocks(SHA2_CTX *context, const uint8_t *data, size_t num_blocks)
+{
+	if (SHA256_accel_blocks(context->state.st32, data, num_blocks))
+		return;
+	for (; num_blocks > 0; num_blocks--, data += SHA256_BLOCK_LENGTH)
+		SHA256Transform(context, data);
+}
+
 void
 SHA256Update(SHA2_CTX *context, const uint8_t *data, size_t len)
 {
@@ -478,7 +490,7 @@ SHA256Update(SHA2_CTX *context, const uint8_t *data, size_t len)
 			context->bitcount[0] += freespace << 3;
 			len -= freespace;
 			data += freespace;
-			SHA256Transform(context, context->buffer);
+			SHA256Transform_blocks(context, context->buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			bcopy(data, &context->buffer[usedspace], len);
@@ -488,12 +500,13 @@ SHA256Update(SHA2_CTX *context, const uint8_t *data, size_t len)
 			return;
 		}
 	}
-	while (len >= SHA256_BLOCK_LENGTH) {
+	if (len >= SHA256_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
-		SHA256Transform(context, data);
-		context->bitcount[0] += SHA256_BLOCK_LENGTH << 3;
-		len -= SHA256_BLOCK_LENGTH;
-		data += SHA256_BLOCK_LENGTH;
+		size_t num_blocks = len / SHA256_BLOCK_LENGTH;
+		SHA256Transform_blocks(context, data, num_blocks);
+		context->bitcount[0] += (uint64_t)num_blocks * SHA256_BLOCK_LENGTH << 3;
+		len -= num_blocks * SHA256_BLOCK_LENGTH;
+		data += num_blocks * SHA256_BLOCK_LENGTH;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -529,7 +542,7 @@ SHA256Final(uint8_t digest[], SHA2_CTX *context)
 					bzero(&context->buffer[usedspace], SHA256_BLOCK_LENGTH - usedspace);
 				}
 				/* Do second-to-last transform: */
-				SHA256Transform(context, context->buffer);
+				SHA256Transform_blocks(context, context->buffer, 1);
 
 				/* And set-up for the last transform: */
 				bzero(context->buffer, SHA256_SHORT_BLOCK_LENGTH);
@@ -545,7 +558,7 @@ SHA256Final(uint8_t digest[], SHA2_CTX *context)
 		*(uint64_t *)&context->buffer[SHA256_SHORT_BLOCK_LENGTH] = context->bitcount[0];
 
 		/* Final transform: */
-		SHA256Transform(context, context->buffer);
+		SHA256Transform_blocks(context, context->buffer, 1);
 
 #if BYTE_ORDER == LITTLE_ENDIAN
 		{
@@ -0,0 +1,371 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "sha256_accel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define SHA256_ACCEL_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#ifdef SHA256_ACCEL_X86
+
+static bool have_sha = false;
+static bool have_avx2 = false;
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+
+static void SHA256_accel_detect(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return;
+    bool have_ssse3 = (ecx & bit_SSSE3) != 0;
+    bool have_sse41 = (ecx & bit_SSE4_1) != 0;
+    bool have_avx = (ecx & bit_AVX) != 0;
+
+    // The AVX registers are only usable if the operating system saves them
+    bool os_saves_ymm = false;
+    if ((ecx & bit_OSXSAVE) != 0)
+    {
+        unsigned int xcr0_low, xcr0_high;
+        __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+        os_saves_ymm = (xcr0_low & 0x6) == 0x6;
+    }
+
+    if (__get_cpuid_max(0, NULL) < 7)
+        return;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+    have_sha = have_ssse3 && have_sse41 && (ebx & bit_SHA) != 0;
+    have_avx2 = have_avx && os_saves_ymm && (ebx & bit_AVX2) != 0;
+}
+
+// The round constants, as in sha2-openbsd.c
+static const uint32_t K256[64] = {
+    0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL,
+    0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL, 0xd807aa98UL, 0x12835b01UL,
+    0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL,
+    0xc19bf174UL, 0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
+    0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL, 0x983e5152UL,
+    0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL,
+    0x06ca6351UL, 0x14292967UL, 0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL,
+    0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+    0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL,
+    0xd6990624UL, 0xf40e3585UL, 0x106aa070UL, 0x19a4c116UL, 0x1e376c08UL,
+    0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL,
+    0x682e6ff3UL, 0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
+    0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL};
+
+static const uint32_t H256[8] = {0x6a09e667UL, 0xbb67ae85UL, 0x3c6ef372UL,
+                                 0xa54ff53aUL, 0x510e527fUL, 0x9b05688cUL,
+                                 0x1f83d9abUL, 0x5be0cd19UL};
+
+/* SHA extensions */
+
+// Four rounds, with the message words in m and the constants from K256[k]
+#define SHA_ROUNDS(m, k)                                                       \
+    do                                                                         \
+    {                                                                          \
+        __m128i wk = _mm_add_epi32(                                            \
+            m, _mm_loadu_si128((const __m128i *)&K256[k]));                    \
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk);                          \
+        wk = _mm_shuffle_epi32(wk, 0x0e);                                      \
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, wk);                          \
+    } while (0)
+
+// Replace the oldest four message words, m0, with the next four
+#define SHA_SCHEDULE(m0, m1, m2, m3)                                           \
+    m0 = _mm_sha256msg2_epu32(                                                 \
+        _mm_add_epi32(_mm_sha256msg1_epu32(m0, m1),                            \
+                      _mm_alignr_epi8(m3, m2, 4)),                             \
+        m3)
+
+__attribute__((target("sha,sse4.1,ssse3"))) static void
+SHA256_blocks_sha(uint32_t state[8], const uint8_t *data, size_t num_blocks)
+{
+    const __m128i byte_swap =
+        _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The instructions keep the state as the halves ABEF and CDGH
+    __m128i dcba = _mm_loadu_si128((const __m128i *)&state[0]);
+    __m128i hgfe = _mm_loadu_si128((const __m128i *)&state[4]);
+    __m128i cdab = _mm_shuffle_epi32(dcba, 0xb1);
+    __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1b);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+
+    for (; num_blocks > 0; num_blocks--, data += SHA256_BLOCK_LENGTH)
+    {
+        __m128i abef_before = abef, cdgh_before = cdgh;
+
+        __m128i m0 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(data + 0)), byte_swap);
+        __m128i m1 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(data + 16)), byte_swap);
+        __m128i m2 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(data + 32)), byte_swap);
+        __m128i m3 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(data + 48)), byte_swap);
+
+        SHA_ROUNDS(m0, 0);
+        SHA_ROUNDS(m1, 4);
+        SHA_ROUNDS(m2, 8);
+        SHA_ROUNDS(m3, 12);
+        for (int k = 16; k < 64; k += 16)
+        {
+            SHA_SCHEDULE(m0, m1, m2, m3);
+            SHA_ROUNDS(m0, k);
+            SHA_SCHEDULE(m1, m2, m3, m0);
+            SHA_ROUNDS(m1, k + 4);
+            SHA_SCHEDULE(m2, m3, m0, m1);
+            SHA_ROUNDS(m2, k + 8);
+            SHA_SCHEDULE(m3, m0, m1, m2);
+            SHA_ROUNDS(m3, k + 12);
+        }
+
+        abef = _mm_add_epi32(abef, abef_before);
+        cdgh = _mm_add_epi32(cdgh, cdgh_before);
+    }
+
+    cdab = _mm_shuffle_epi32(abef, 0x1b);
+    efgh = _mm_shuffle_epi32(cdgh, 0xb1);
+    dcba = _mm_blend_epi16(cdab, efgh, 0xf0);
+    hgfe = _mm_alignr_epi8(efgh, cdab, 8);
+    _mm_storeu_si128((__m128i *)&state[0], dcba);
+    _mm_storeu_si128((__m128i *)&state[4], hgfe);
+}
+
+#undef SHA_ROUNDS
+#undef SHA_SCHEDULE
+
+/* AVX2, one message in each of the eight lanes */
+
+#define SHA_LANES 8
+
+#define ROTR(x, n)                                                             \
+    _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+// Transpose the 8 by 8 matrix of words in r, so that word j of r[i]
+// becomes word i of r[j]
+__attribute__((target("avx2"))) static void SHA256_transpose(__m256i r[8])
+{
+    __m256i t[8], u[8];
+    for (int i = 0; i < 8; i += 2)
+    {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (int i = 0; i < 8; i += 4)
+    {
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+// Load eight words from each of the blocks, big endian, one block per lane
+__attribute__((target("avx2"))) static void
+SHA256_load_words(__m256i w[8], const uint8_t *const blocks[SHA_LANES],
+                  size_t offset)
+{
+    const __m256i byte_swap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7,
+        6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (int i = 0; i < SHA_LANES; i++)
+        w[i] = _mm256_shuffle_epi8(
+            _mm256_loadu_si256((const __m256i *)(blocks[i] + offset)),
+            byte_swap);
+    SHA256_transpose(w);
+}
+
+// Compress one block for each lane into state, leaving the lanes that are
+// not active as they were
+__attribute__((target("avx2"))) static void
+SHA256_compress_lanes(__m256i state[8], const uint8_t *const blocks[SHA_LANES],
+                      __m256i active)
+{
+    __m256i w[16];
+    SHA256_load_words(&w[0], blocks, 0);
+    SHA256_load_words(&w[8], blocks, 32);
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 64; t++)
+    {
+        if (t >= 16)
+        {
+            __m256i w15 = w[(t + 1) & 0x0f], w2 = w[(t + 14) & 0x0f];
+            __m256i s0 = _mm256_xor_si256(
+                _mm256_xor_si256(ROTR(w15, 7), ROTR(w15, 18)),
+                _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(
+                _mm256_xor_si256(ROTR(w2, 17), ROTR(w2, 19)),
+                _mm256_srli_epi32(w2, 10));
+            w[t & 0x0f] = _mm256_add_epi32(
+                _mm256_add_epi32(w[t & 0x0f], s0),
+                _mm256_add_epi32(w[(t + 9) & 0x0f], s1));
+        }
+
+        __m256i sigma1 = _mm256_xor_si256(
+            _mm256_xor_si256(ROTR(e, 6), ROTR(e, 11)), ROTR(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f),
+                                      _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_add_epi32(h, sigma1), ch),
+            _mm256_add_epi32(_mm256_set1_epi32((int)K256[t]), w[t & 0x0f]));
+        __m256i sigma0 = _mm256_xor_si256(
+            _mm256_xor_si256(ROTR(a, 2), ROTR(a, 13)), ROTR(a, 22));
+        __m256i maj = _mm256_or_si256(
+            _mm256_and_si256(a, b),
+            _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(sigma0, maj);
+
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+
+    __m256i after[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; i++)
+        state[i] = _mm256_blendv_epi8(
+            state[i], _mm256_add_epi32(state[i], after[i]), active);
+}
+
+// Hash up to SHA_LANES messages at once
+__attribute__((target("avx2"))) static void
+SHA256_multi_lanes(size_t count, const uint8_t *const *messages,
+                   const size_t *lens,
+                   uint8_t (*digests)[SHA256_DIGEST_LENGTH])
+{
+    static const uint8_t unused_block[SHA256_BLOCK_LENGTH];
+
+    // The padded end of each message, past its last whole block
+    uint8_t tails[SHA_LANES][2 * SHA256_BLOCK_LENGTH];
+    size_t whole_blocks[SHA_LANES];
+    size_t num_blocks[SHA_LANES];
+    size_t max_blocks = 0;
+
+    for (size_t i = 0; i < SHA_LANES; i++)
+    {
+        if (i >= count)
+        {
+            whole_blocks[i] = num_blocks[i] = 0;
+            continue;
+        }
+
+        size_t len = lens[i];
+        whole_blocks[i] = len / SHA256_BLOCK_LENGTH;
+        size_t rest = len % SHA256_BLOCK_LENGTH;
+        size_t tail_blocks = rest < SHA256_BLOCK_LENGTH - 8 ? 1 : 2;
+        num_blocks[i] = whole_blocks[i] + tail_blocks;
+        if (num_blocks[i] > max_blocks)
+            max_blocks = num_blocks[i];
+
+        uint8_t *tail = tails[i];
+        memset(tail, 0, sizeof(tails[i]));
+        if (rest > 0)
+            memcpy(tail, messages[i] + whole_blocks[i] * SHA256_BLOCK_LENGTH,
+                   rest);
+        tail[rest] = 0x80;
+        uint64_t bits = (uint64_t)len << 3;
+        uint8_t *end = tail + tail_blocks * SHA256_BLOCK_LENGTH;
+        for (int j = 1; j <= 8; j++, bits >>= 8)
+            end[-j] = (uint8_t)bits;
+    }
+
+    __m256i state[8];
+    for (int j = 0; j < 8; j++)
+        state[j] = _mm256_set1_epi32((int)H256[j]);
+
+    for (size_t n = 0; n < max_blocks; n++)
+    {
+        const uint8_t *blocks[SHA_LANES];
+        int32_t active[SHA_LANES];
+        for (size_t i = 0; i < SHA_LANES; i++)
+        {
+            active[i] = n < num_blocks[i] ? -1 : 0;
+            if (n < whole_blocks[i])
+                blocks[i] = messages[i] + n * SHA256_BLOCK_LENGTH;
+            else if (n < num_blocks[i])
+                blocks[i] = tails[i] + (n - whole_blocks[i]) * SHA256_BLOCK_LENGTH;
+            else
+                blocks[i] = unused_block;
+        }
+        SHA256_compress_lanes(state, blocks,
+                              _mm256_loadu_si256((const __m256i *)active));
+    }
+
+    // Back to one message per register, and big endian
+    const __m256i byte_swap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7,
+        6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    SHA256_transpose(state);
+    for (size_t i = 0; i < count; i++)
+        _mm256_storeu_si256((__m256i *)digests[i],
+                            _mm256_shuffle_epi8(state[i], byte_swap));
+}
+
+#undef ROTR
+
+bool SHA256_accel_blocks(uint32_t state[8], const uint8_t *data,
+                         size_t num_blocks)
+{
+    pthread_once(&detect_once, SHA256_accel_detect);
+    if (!have_sha)
+        return false;
+    SHA256_blocks_sha(state, data, num_blocks);
+    return true;
+}
+
+#else /* SHA256_ACCEL_X86 */
+
+bool SHA256_accel_blocks(uint32_t state[8], const uint8_t *data,
+                         size_t num_blocks)
+{
+    (void)state;
+    (void)data;
+    (void)num_blocks;
+    return false;
+}
+
+#endif /* SHA256_ACCEL_X86 */
+
+void SHA256_multi(size_t count, const uint8_t *const *messages,
+                  const size_t *lens,
+                  uint8_t (*digests)[SHA256_DIGEST_LENGTH])
+{
+#ifdef SHA256_ACCEL_X86
+    // The SHA extensions beat eight lanes of AVX2, so only use those
+    // without them
+    pthread_once(&detect_once, SHA256_accel_detect);
+    if (have_avx2 && !have_sha)
+    {
+        for (size_t i = 0; i < count; i += SHA_LANES)
+            SHA256_multi_lanes(count - i < SHA_LANES ? count - i : SHA_LANES,
+                               messages + i, lens + i, digests + i);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < count; i++)
+    {
+        SHA2_CTX context;
+        SHA256Init(&context);
+        SHA256Update(&context, messages[i], lens[i]);
+        SHA256Final(digests[i], &context);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef __SHA256_ACCEL_H__
+#define __SHA256_ACCEL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sha2-openbsd.h"
+
+// @design SHA-256 on the instructions the processor offers, chosen the
+// first time they are needed. Single messages use the SHA extensions where
+// they exist. Batches of independent messages, such as the ballot trackers
+// of a batch of ballots, are hashed eight at a time across the lanes of the
+// AVX2 registers on processors that have those but not the SHA extensions.
+// Everything else falls back to the portable code in sha2-openbsd.c.
+
+/* Compress num_blocks consecutive 64 byte blocks of data into state with
+ * the SHA extensions. Returns false, having done nothing, if the processor
+ * lacks them. */
+bool SHA256_accel_blocks(uint32_t state[8], const uint8_t *data,
+                         size_t num_blocks);
+
+/* Set digests[i] to the SHA-256 digest of the lens[i] bytes at messages[i],
+ * for each of the count messages */
+void SHA256_multi(size_t count, const uint8_t *const *messages,
+                  const size_t *lens,
+                  uint8_t (*digests)[SHA256_DIGEST_LENGTH]);
+
+#endif /* __SHA256_ACCEL_H__ */
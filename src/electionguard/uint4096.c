@@ -35,11 +35,14 @@ typedef struct Modulus4096_s {
 
 // Returns whether the addition overflowed or not.
 bool uintnwords_add_o(size_t n, UINT4096_WORD_T *out, const UINT4096_WORD_T *a, const UINT4096_WORD_T *b) {
-    // Simple ripple-carry adder.
+    // Simple ripple-carry adder. The operands are read before out is written,
+    // since out may alias them, and __builtin_add_overflow may read its
+    // arguments again after the store to decide whether it overflowed.
     UINT4096_WORD_T carry = 0;
     while(n-- > 0) {
+        const UINT4096_WORD_T a_word = a[n], b_word = b[n];
         UINT4096_WORD_T new_carry = 0;
-        new_carry |= !!__builtin_add_overflow(a[n], b[n], out+n);
+        new_carry |= !!__builtin_add_overflow(a_word, b_word, out+n);
         new_carry |= !!__builtin_add_overflow(out[n], carry, out+n);
         carry = new_carry;
     }
@@ -51,7 +54,8 @@ bool uintnwords_succ_o(size_t n, UINT4096_WORD_T *out, const UINT4096_WORD_T *a)
     bool carry = true;
     // timing
     while(carry && n-- > 0) {
-        carry = __builtin_add_overflow(a[n], 1, out+n);
+        const UINT4096_WORD_T a_word = a[n];
+        carry = __builtin_add_overflow(a_word, 1, out+n);
     }
     return carry;
 }
@@ -265,23 +269,58 @@ void uint4096_copy_o(uint4096 out, const_uint4096 src) {
 // Currently just a wrapper around free; exists for abstraction boundary's sake.
 void uint4096_free(uint4096 a) { free(a); }
 
-bool uint4096_fprint(FILE *out, const_uint4096 a) {
-    if(2 != fprintf(out, "0x")) return false;
+static const char hex_digits[16] = "0123456789abcdef";
+
+// The value of each hex digit with 0x10 set; anything else maps to 0, so a
+// whole number can be checked for bad digits once at the end.
+static const uint8_t hex_digit_values[256] = {
+    ['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14,
+    ['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19,
+    ['a'] = 0x1a, ['b'] = 0x1b, ['c'] = 0x1c, ['d'] = 0x1d, ['e'] = 0x1e, ['f'] = 0x1f,
+    ['A'] = 0x1a, ['B'] = 0x1b, ['C'] = 0x1c, ['D'] = 0x1d, ['E'] = 0x1e, ['F'] = 0x1f,
+};
+
+void uint4096_to_hex(char *out, const_uint4096 a) {
+    *out++ = '0';
+    *out++ = 'x';
     for(size_t i = 0; i < UINT4096_WORD_COUNT; i++) {
-        if(2*UINT4096_WORD_SIZE_BYTES != fprintf(out, PRIxUINT4096_WORD_T, a->words[i]))
-            return false;
+        UINT4096_WORD_T word = a->words[i];
+        for(int j = 2*UINT4096_WORD_SIZE_BYTES - 1; j >= 0; j--) {
+            out[j] = hex_digits[word & 0xf];
+            word >>= 4;
+        }
+        out += 2*UINT4096_WORD_SIZE_BYTES;
     }
-    return true;
 }
 
-bool uint4096_fscan(FILE *in, uint4096 out) {
-    int num_read = fscanf(in, "0x");
-    if(0 != num_read) return false;
+bool uint4096_from_hex(uint4096 out, const char *in) {
+    if(in[0] != '0' || in[1] != 'x') return false;
+    in += 2;
+
+    uint8_t valid = 0x10;
     for(size_t i = 0; i < UINT4096_WORD_COUNT; i++) {
-        num_read = fscanf(in, PRIxUINT4096_WORD_T, &out->words[i]);
-        if(1 != num_read) return false;
+        UINT4096_WORD_T word = 0;
+        for(size_t j = 0; j < 2*UINT4096_WORD_SIZE_BYTES; j++) {
+            uint8_t digit = hex_digit_values[(unsigned char)in[j]];
+            valid &= digit;
+            word = word << 4 | (digit & 0xf);
+        }
+        out->words[i] = word;
+        in += 2*UINT4096_WORD_SIZE_BYTES;
     }
-    return true;
+    return valid != 0;
+}
+
+bool uint4096_fprint(FILE *out, const_uint4096 a) {
+    char buf[UINT4096_HEX_LENGTH];
+    uint4096_to_hex(buf, a);
+    return 1 == fwrite(buf, sizeof buf, 1, out);
+}
+
+bool uint4096_fscan(FILE *in, uint4096 out) {
+    char buf[UINT4096_HEX_LENGTH];
+    if(1 != fread(buf, sizeof buf, 1, in)) return false;
+    return uint4096_from_hex(out, buf);
 }
 
 // =============================================================================
@@ -371,22 +410,22 @@ struct Modulus4096_s p_4 = {
             0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
             0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
             0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000001,
-            0x0000000000000000, 0x36F0255DDE973DCB, 0x4703CE7E2E815197, 0xA6DB0F588448B611,
-            0x64CFCAC5F1872E51, 0xB1F9FBB5BF16FBE7, 0x9689FC0903A801E3, 0xD4802FB8D329550D,
-            0xC8C9D3D922EECE9A, 0x5475DB33DB7B83BB, 0x5C0E13D168049BBC, 0x86C5817647B088D1,
-            0x7AA5CC40E0203558, 0x8EDB2DE189934137, 0x19FC258D79BC217A, 0xC4B8739CBEA038AA,
-            0xA88D0D2F78A77A8A, 0x6FC7FAA8B2BDCA9B, 0xE7502D2F5F6A7B65, 0xF5E4F07AB8B286E4,
-            0x1115F024A6E976BD, 0x2BCE3E5190B891AB, 0xBF2331E9C94DE91F, 0xBE8574370494A354,
-            0xEAC9BE0B31EB3185, 0x40E4069D556E9DD0, 0x9D5D89D7DE4A75C8, 0x8BB49316C106E4E0,
-            0x14B636E60FEBC292, 0xE6249105F5B195FE, 0x906EEF7D26CAF052, 0x9A3E0BC10E100CE0,
-            0xA899C59999BF877D, 0xBA72C59BF5CCF326, 0x2EB59041E144783A, 0xEE4CD860EE0B6450,
-            0x6DAB2569611BADDB, 0x6B78E82043041716, 0xDEC14CC95569811E, 0x498FDEC9D54BD071,
-            0x1EC97A0B25201C17, 0x763900498B0F0308, 0x746D18CEEDB565FF, 0x29964AFA53E3C1B9,
-            0x67ED5909172FB4D7, 0xF345A315C4768765, 0x5294F5E127281391, 0x0C258E7E91556CE5,
-            0xC145E09DAE0A5C7E, 0xEDE843F90F5DA834, 0x399A4ECB4B05F36F, 0xE586ABCAEF7FA12E,
-            0x18B7F0A5564A1616, 0x5D4680FE70FC2A3F, 0xEDFD7374A1D9CA9A, 0xEFBDDF3F3060E354,
-            0x8E1CD71EA518F66B, 0x9725EFEC54AEDB55, 0xAE1CF670C7E28D82, 0x07F6D09E269060E5,
-            0x591A0721ADFEA421, 0x8E27DA72BF177212, 0x072053629D931252, 0xC14AB0DDCC03AA20
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+            0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000045,
+            0x0000000000000000, 0x0000000000000000, 0x01FE8A1CF4E4F186, 0xE24AFD66B0DB204F
         }
     }
 };
@@ -64,6 +64,13 @@ void uint4096_multmod_o(uint4096 out, const_uint4096 a, const_uint4096 b, Modulu
 void uint4096_powmod_o(uint4096 out, const_uint4096 base, const_uint4096 exponent, Modulus4096 modulus);
 void uint4096_copy_o(uint4096 out, const_uint4096 src);
 
+// The text form of a uint4096 is "0x" followed by exactly 1024 hex digits.
+// The _hex functions convert UINT4096_HEX_LENGTH characters, with no
+// terminating NUL, in one pass over a buffer.
+#define UINT4096_HEX_LENGTH (2 + 2*UINT4096_WORD_COUNT*UINT4096_WORD_SIZE_BYTES)
+void uint4096_to_hex(char *out, const_uint4096 a);
+bool uint4096_from_hex(uint4096 out, const char *in);
+
 bool uint4096_fprint(FILE *out, const_uint4096 a);
 bool uint4096_fscan(FILE *in, uint4096 out);
 
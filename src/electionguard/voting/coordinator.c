@@ -1,4 +1,5 @@
 #include <inttypes.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -6,6 +7,7 @@
 
 #include <log.h>
 
+#include "ballot_record.h"
 #include "crypto_reps.h"
 #include "serialize/crypto.h"
 #include "serialize/voting.h"
@@ -20,6 +22,21 @@
 // there should only ever be one voting coordinator in memory on a system
 // and it should retain it's state through the ballot load and cast cycle
 
+// Ballots are buffered in chunks of this many, so that the buffer grows
+// without moving or copying the ballots already in it
+#define VOTING_COORDINATOR_CHUNK_SIZE 1024
+
+/**
+ * A registered ballot waiting to be exported
+ */
+struct Voting_Coordinator_buffered_ballot
+{
+    // handle to the caller's external id
+    char *external_id;
+
+    struct encryption_rep *selections;
+};
+
 /**
  * The current state of a voting coordinator
  */
@@ -34,13 +51,59 @@ struct Voting_Coordinator_s
     // count of ballots in the buffer
     uint32_t buffered_num_ballots;
 
-    // external id buffer
-    char *buffered_external_id[MAX_BALLOT_PAYLOAD];
+    // the most ballots the coordinator tracks, or 0 for no limit
+    uint64_t max_ballots;
 
-    // selections buffer
-    struct encryption_rep *selections[MAX_BALLOT_PAYLOAD];
+    // the buffer, num_chunks chunks of VOTING_COORDINATOR_CHUNK_SIZE
+    // ballots, kept allocated when it is cleared
+    struct Voting_Coordinator_buffered_ballot **chunks;
+    uint32_t num_chunks;
+    uint32_t chunks_capacity;
 };
 
+static struct Voting_Coordinator_buffered_ballot *
+Voting_Coordinator_buffered_ballot(Voting_Coordinator coordinator, uint32_t i)
+{
+    return &coordinator->chunks[i / VOTING_COORDINATOR_CHUNK_SIZE]
+                               [i % VOTING_COORDINATOR_CHUNK_SIZE];
+}
+
+// Make room in the buffer for one more ballot
+static enum Voting_Coordinator_status
+Voting_Coordinator_reserve_buffer(Voting_Coordinator coordinator)
+{
+    if (coordinator->buffered_num_ballots <
+        coordinator->num_chunks * VOTING_COORDINATOR_CHUNK_SIZE)
+        return VOTING_COORDINATOR_SUCCESS;
+
+    if (coordinator->buffered_num_ballots >
+        UINT32_MAX - VOTING_COORDINATOR_CHUNK_SIZE)
+        return VOTING_COORDINATOR_INSUFFICIENT_MEMORY;
+
+    if (coordinator->num_chunks == coordinator->chunks_capacity)
+    {
+        uint32_t capacity = coordinator->chunks_capacity == 0
+                                ? 1
+                                : 2 * coordinator->chunks_capacity;
+        struct Voting_Coordinator_buffered_ballot **chunks = realloc(
+            coordinator->chunks,
+            capacity * sizeof(struct Voting_Coordinator_buffered_ballot *));
+        if (chunks == NULL)
+            return VOTING_COORDINATOR_INSUFFICIENT_MEMORY;
+        coordinator->chunks = chunks;
+        coordinator->chunks_capacity = capacity;
+    }
+
+    struct Voting_Coordinator_buffered_ballot *chunk =
+        malloc(VOTING_COORDINATOR_CHUNK_SIZE *
+               sizeof(struct Voting_Coordinator_buffered_ballot));
+    if (chunk == NULL)
+        return VOTING_COORDINATOR_INSUFFICIENT_MEMORY;
+    coordinator->chunks[coordinator->num_chunks++] = chunk;
+
+    return VOTING_COORDINATOR_SUCCESS;
+}
+
 static int Voting_Coordinator_ref_count = 0;
 
 // use a static result as a singleton instance
@@ -87,6 +150,10 @@ struct Voting_Coordinator_new_r Voting_Coordinator_new(uint32_t num_selections)
         voting_coordinator_singleton.coordinator->num_selections = num_selections;
         voting_coordinator_singleton.coordinator->registered_num_ballots = 0;
         voting_coordinator_singleton.coordinator->buffered_num_ballots = 0;
+        voting_coordinator_singleton.coordinator->max_ballots = 0;
+        voting_coordinator_singleton.coordinator->chunks = NULL;
+        voting_coordinator_singleton.coordinator->num_chunks = 0;
+        voting_coordinator_singleton.coordinator->chunks_capacity = 0;
 
         Ballot_Collection_new();
 
@@ -100,25 +167,31 @@ struct Voting_Coordinator_new_r Voting_Coordinator_new(uint32_t num_selections)
     return voting_coordinator_singleton;
 }
 
+void Voting_Coordinator_set_max_ballots(Voting_Coordinator coordinator,
+                                        uint64_t max_ballots)
+{
+    coordinator->max_ballots = max_ballots;
+}
+
 enum Voting_Coordinator_status Voting_Coordinator_clear_buffer(Voting_Coordinator coordinator)
 {
     for(uint32_t i = 0; i < coordinator->buffered_num_ballots; i++)
     {
+        struct Voting_Coordinator_buffered_ballot *ballot =
+            Voting_Coordinator_buffered_ballot(coordinator, i);
+
         // clear the slections buffer
-        if (coordinator->selections[i] != NULL)
+        if (ballot->selections != NULL)
         {
             for(uint32_t j = 0; j < coordinator->num_selections; j++)
             {
-                Crypto_encryption_rep_free(&coordinator->selections[i][j]);
+                Crypto_encryption_rep_free(&ballot->selections[j]);
             }
         }
 
         // clear references to buffered external_id's
         // but don't actually free the strings
-        if (coordinator->buffered_external_id[i] != NULL)
-        {
-            coordinator->buffered_external_id[i] = NULL;
-        }
+        ballot->external_id = NULL;
     }
 
     coordinator->buffered_num_ballots = 0;
@@ -145,6 +218,10 @@ void Voting_Coordinator_free(Voting_Coordinator coordinator)
     Voting_Coordinator_clear_buffer(coordinator);
     Ballot_Collection_free();
 
+    for (uint32_t i = 0; i < coordinator->num_chunks; i++)
+        free(coordinator->chunks[i]);
+    free(coordinator->chunks);
+
     coordinator->num_selections = 0;
     coordinator->buffered_num_ballots = 0;
     coordinator->registered_num_ballots = 0;
@@ -171,13 +248,16 @@ Voting_Coordinator_register_ballot(Voting_Coordinator coordinator,
     }
 
     // Verify we can load another ballot into the ballot state cache
-    if (Ballot_Collection_size() >= MAX_BALLOTS)
+    if ((coordinator->max_ballots != 0 &&
+         Ballot_Collection_size() >= coordinator->max_ballots) ||
+        coordinator->registered_num_ballots == UINT32_MAX)
     {
         return VOTING_COORDINATOR_INVALID_BALLOT_INDEX;
     }
 
     // Verify we can load another ballot into the selections buffer cache
-    if (coordinator->buffered_num_ballots >= MAX_BALLOT_PAYLOAD)
+    if (Voting_Coordinator_reserve_buffer(coordinator) !=
+        VOTING_COORDINATOR_SUCCESS)
     {
         return VOTING_COORDINATOR_INSUFFICIENT_MEMORY;
     }
@@ -233,11 +313,15 @@ Voting_Coordinator_register_ballot(Voting_Coordinator coordinator,
         return VOTING_COORDINATOR_IO_ERROR;
     }
 
+    struct Voting_Coordinator_buffered_ballot *ballot =
+        Voting_Coordinator_buffered_ballot(coordinator,
+                                           coordinator->buffered_num_ballots);
+
     // cache a handle to the external id for lookups
-    coordinator->buffered_external_id[coordinator->buffered_num_ballots] = external_identifier;
+    ballot->external_id = external_identifier;
 
     // cache the ballot selections in the buffer
-    coordinator->selections[coordinator->buffered_num_ballots] = message_rep.selections;
+    ballot->selections = message_rep.selections;
         
     coordinator->registered_num_ballots++;
     coordinator->buffered_num_ballots++;
@@ -348,14 +432,20 @@ Voting_Coordinator_write_ballot(FILE *out, uint32_t registered_ballot_index, boo
     return status;
 }
 
+// Digits in the ballot count on the first line of a ballots file, enough
+// for any uint32_t, so that the count can be rewritten in place
+#define VOTING_COORDINATOR_COUNT_WIDTH 10
+
 static enum Voting_Coordinator_status
-Voting_Coordinator_write_ballots_file_header(Voting_Coordinator coordinator, FILE *out)
+Voting_Coordinator_write_ballots_file_header(Voting_Coordinator coordinator, FILE *out,
+                                             uint32_t num_ballots)
 {
     enum Voting_Coordinator_status status = VOTING_COORDINATOR_SUCCESS;
 
     // Write the first line containing the number of ballots
     {
-        int io_status = fprintf(out, "%" PRIu32 "\n", coordinator->registered_num_ballots);
+        int io_status = fprintf(out, "%0*" PRIu32 "\n",
+                                VOTING_COORDINATOR_COUNT_WIDTH, num_ballots);
         if (io_status < 0)
             status = VOTING_COORDINATOR_IO_ERROR;
     }
@@ -371,35 +461,130 @@ Voting_Coordinator_write_ballots_file_header(Voting_Coordinator coordinator, FIL
     return status;
 }
 
-enum Voting_Coordinator_status
-Voting_Coordinator_export_buffered_ballots(Voting_Coordinator coordinator, FILE *out)
+// Bytes moved at a time when making room for a fixed-width count
+#define VOTING_COORDINATOR_MIGRATE_CHUNK 4096
+
+// Rewrite the header of a ballots file written before the count was
+// fixed-width, whose ballots start at body. Such a count was not always
+// the number of ballots in the file, so the ballots are counted, one to a
+// line. They are moved up to make room for the wider count, from the end
+// backwards so that none is overwritten before it is moved.
+static enum Voting_Coordinator_status
+Voting_Coordinator_migrate_ballots_file_header(Voting_Coordinator coordinator,
+                                               FILE *io, long body,
+                                               uint32_t *num_ballots)
 {
     enum Voting_Coordinator_status status = VOTING_COORDINATOR_SUCCESS;
 
-    // ensure the file cursor is at the beginning
-    int seek_status = fseek(out, 0L, SEEK_SET);
+    uint64_t count = 0;
+    int c;
+    while ((c = fgetc(io)) != EOF)
+        if (c == '\n')
+            count++;
+
+    long end = 0;
+    if (ferror(io) || (end = ftell(io)) < 0)
+        status = VOTING_COORDINATOR_IO_ERROR;
+    else if (count > UINT32_MAX - coordinator->buffered_num_ballots)
+        status = VOTING_COORDINATOR_INVALID_DATA;
+
+    // How far the ballots move for the header written below
+    long shift = VOTING_COORDINATOR_COUNT_WIDTH + 1 - body +
+                 snprintf(NULL, 0, "%" PRIu32 "\n", coordinator->num_selections);
+    if (status == VOTING_COORDINATOR_SUCCESS && shift <= 0)
+        status = VOTING_COORDINATOR_INVALID_DATA;
 
-    // write the header
-    status = Voting_Coordinator_write_ballots_file_header(coordinator, out);
-    if (status != VOTING_COORDINATOR_SUCCESS) 
+    uint8_t buf[VOTING_COORDINATOR_MIGRATE_CHUNK];
+    for (long pos = end; pos > body && status == VOTING_COORDINATOR_SUCCESS;)
     {
-        return status;
+        size_t n = pos - body < (long)sizeof buf ? (size_t)(pos - body)
+                                                 : sizeof buf;
+        pos -= (long)n;
+        if (fseek(io, pos, SEEK_SET) != 0 || fread(buf, 1, n, io) != n ||
+            fseek(io, pos + shift, SEEK_SET) != 0 ||
+            fwrite(buf, 1, n, io) != n)
+            status = VOTING_COORDINATOR_IO_ERROR;
     }
 
-    // flush the write buffer before reading the file
-    fflush(out);
+    if (status == VOTING_COORDINATOR_SUCCESS && fseek(io, 0L, SEEK_SET) != 0)
+        status = VOTING_COORDINATOR_IO_ERROR;
+
+    if (status == VOTING_COORDINATOR_SUCCESS)
+        status = Voting_Coordinator_write_ballots_file_header(
+            coordinator, io, (uint32_t)count);
+
+    if (status == VOTING_COORDINATOR_SUCCESS)
+        *num_ballots = (uint32_t)count;
+
+    return status;
+}
+
+// Read the number of ballots already in a ballots file from its header.
+// Files written before the count was fixed-width are migrated.
+static enum Voting_Coordinator_status
+Voting_Coordinator_read_ballots_file_header(Voting_Coordinator coordinator, FILE *io,
+                                            uint32_t *num_ballots)
+{
+    enum Voting_Coordinator_status status = VOTING_COORDINATOR_SUCCESS;
+
+    // The count must be fixed-width to be rewritten in place
+    char line[VOTING_COORDINATOR_COUNT_WIDTH + 2];
+    size_t digits = 0;
+    if (fgets(line, sizeof line, io) == NULL ||
+        (digits = strspn(line, "0123456789")) == 0 ||
+        digits > VOTING_COORDINATOR_COUNT_WIDTH || line[digits] != '\n')
+        status = VOTING_COORDINATOR_INVALID_DATA;
 
-    // seek to the end of the file
-    int character, number_of_ballots_written = 0; 
-    while ((character = fgetc(out)) != EOF) 
+    if (status == VOTING_COORDINATOR_SUCCESS)
     {
-        if (character == '\n')
-        {
-            number_of_ballots_written++;
-        }
+        uint32_t num_selections;
+        if (fscanf(io, "%" SCNu32, &num_selections) != 1 ||
+            num_selections != coordinator->num_selections ||
+            fgetc(io) != '\n')
+            status = VOTING_COORDINATOR_INVALID_DATA;
     }
 
-    uint32_t registered_ballot_index = number_of_ballots_written;
+    if (status == VOTING_COORDINATOR_SUCCESS &&
+        digits != VOTING_COORDINATOR_COUNT_WIDTH)
+    {
+        long body = ftell(io);
+        status = body < 0 ? VOTING_COORDINATOR_IO_ERROR
+                          : Voting_Coordinator_migrate_ballots_file_header(
+                                coordinator, io, body, num_ballots);
+    }
+    else if (status == VOTING_COORDINATOR_SUCCESS)
+    {
+        uint64_t count = strtoull(line, NULL, 10);
+        if (count > UINT32_MAX - coordinator->buffered_num_ballots)
+            status = VOTING_COORDINATOR_INVALID_DATA;
+        else
+            *num_ballots = (uint32_t)count;
+    }
+
+    return status;
+}
+
+enum Voting_Coordinator_status
+Voting_Coordinator_export_buffered_ballots(Voting_Coordinator coordinator, FILE *out)
+{
+    enum Voting_Coordinator_status status = VOTING_COORDINATOR_SUCCESS;
+
+    // Add to the ballots already in the file, whose count is in its header
+    uint32_t num_ballots = 0;
+    long end = 0;
+    if (fseek(out, 0L, SEEK_END) != 0 || (end = ftell(out)) < 0 ||
+        fseek(out, 0L, SEEK_SET) != 0)
+        status = VOTING_COORDINATOR_IO_ERROR;
+
+    if (status == VOTING_COORDINATOR_SUCCESS && end > 0)
+        status = Voting_Coordinator_read_ballots_file_header(coordinator, out,
+                                                             &num_ballots);
+    else if (status == VOTING_COORDINATOR_SUCCESS)
+        status = Voting_Coordinator_write_ballots_file_header(coordinator, out,
+                                                              num_ballots);
+
+    if (status == VOTING_COORDINATOR_SUCCESS && fseek(out, 0L, SEEK_END) != 0)
+        status = VOTING_COORDINATOR_IO_ERROR;
 
 #ifdef DEBUG_PRINT 
     printf("\nVoting_Coordinator_export: writing out %u ballots\n\n", coordinator->buffered_num_ballots);
@@ -410,13 +595,16 @@ Voting_Coordinator_export_buffered_ballots(Voting_Coordinator coordinator, FILE
          i < coordinator->buffered_num_ballots && status == VOTING_COORDINATOR_SUCCESS; 
          i++)
     {
+        struct Voting_Coordinator_buffered_ballot *ballot =
+            Voting_Coordinator_buffered_ballot(coordinator, i);
         struct ballot_state *ballot_state = NULL;
         if (Ballot_Collection_get_ballot(
-            coordinator->buffered_external_id[i], &ballot_state
+            ballot->external_id, &ballot_state
         ) != BALLOT_COLLECTION_SUCCESS)
         {
-            printf("\n could not find in cache: %s\n", coordinator->buffered_external_id[i]);
-            return status = VOTING_COORDINATOR_INVALID_BALLOT_ID;
+            printf("\n could not find in cache: %s\n", ballot->external_id);
+            status = VOTING_COORDINATOR_INVALID_BALLOT_ID;
+            break;
         }
 
 #ifdef DEBUG_PRINT 
@@ -426,17 +614,106 @@ Voting_Coordinator_export_buffered_ballots(Voting_Coordinator coordinator, FILE
 
         status = Voting_Coordinator_write_ballot(
             out, 
-            registered_ballot_index, 
+            num_ballots, 
             ballot_state->cast,
             coordinator->num_selections, 
-            coordinator->selections[i]
+            ballot->selections
         );
 
-        registered_ballot_index++;
+        num_ballots++;
+    }
+
+    // Then the header, now that the count is known
+    if (status == VOTING_COORDINATOR_SUCCESS)
+    {
+        if (fseek(out, 0L, SEEK_SET) != 0)
+            status = VOTING_COORDINATOR_IO_ERROR;
+        else
+            status = Voting_Coordinator_write_ballots_file_header(
+                coordinator, out, num_ballots);
+    }
+
+    if (status == VOTING_COORDINATOR_SUCCESS && fflush(out) != 0)
+        status = VOTING_COORDINATOR_IO_ERROR;
+
+    // clear the selections buffer
+    if (status == VOTING_COORDINATOR_SUCCESS)
+        status = Voting_Coordinator_clear_buffer(coordinator);
+
+    return status;
+}
+
+enum Voting_Coordinator_status
+Voting_Coordinator_export_buffered_ballots_binary(Voting_Coordinator coordinator,
+                                                  FILE *out)
+{
+    enum Voting_Coordinator_status status = VOTING_COORDINATOR_SUCCESS;
+
+    struct ballot_record_header header = {
+        .num_selections = coordinator->num_selections,
+        .external_id_width = 0,
+        .num_records = 0,
+    };
+
+    // Add to the ballots already in the file, whose count is in its header
+    if (fseek(out, 0L, SEEK_SET) != 0)
+        status = VOTING_COORDINATOR_IO_ERROR;
+
+    if (status == VOTING_COORDINATOR_SUCCESS && Ballot_Record_is_binary(out))
+    {
+        struct ballot_record_header existing;
+        if (Ballot_Record_read_header(out, &existing) != BALLOT_RECORD_SUCCESS ||
+            existing.num_selections != coordinator->num_selections)
+            status = VOTING_COORDINATOR_INVALID_DATA;
+        else
+            header = existing;
+    }
+
+    if (status == VOTING_COORDINATOR_SUCCESS)
+    {
+        long end = BALLOT_RECORD_HEADER_SIZE +
+                   (long)(header.num_records * Ballot_Record_record_size(&header));
+        if (fseek(out, end, SEEK_SET) != 0)
+            status = VOTING_COORDINATOR_IO_ERROR;
+    }
+
+    // Write each ballot
+    for (uint32_t i = 0;
+         i < coordinator->buffered_num_ballots && status == VOTING_COORDINATOR_SUCCESS; 
+         i++)
+    {
+        struct Voting_Coordinator_buffered_ballot *ballot =
+            Voting_Coordinator_buffered_ballot(coordinator, i);
+        struct ballot_state *ballot_state = NULL;
+        if (Ballot_Collection_get_ballot(
+            ballot->external_id, &ballot_state
+        ) != BALLOT_COLLECTION_SUCCESS)
+        {
+            status = VOTING_COORDINATOR_INVALID_BALLOT_ID;
+            break;
+        }
+
+        if (Ballot_Record_write(out, &header, header.num_records,
+                                ballot_state->cast, NULL,
+                                ballot->selections) !=
+            BALLOT_RECORD_SUCCESS)
+            status = VOTING_COORDINATOR_IO_ERROR;
+
+        header.num_records++;
+    }
+
+    // Then the header, now that the count is known
+    if (status == VOTING_COORDINATOR_SUCCESS)
+    {
+        if (fseek(out, 0L, SEEK_SET) != 0 ||
+            Ballot_Record_write_header(out, &header) != BALLOT_RECORD_SUCCESS ||
+            fflush(out) != 0)
+            status = VOTING_COORDINATOR_IO_ERROR;
     }
 
     // clear the selections buffer
-    status = Voting_Coordinator_clear_buffer(coordinator);
+    if (status == VOTING_COORDINATOR_SUCCESS)
+        status = Voting_Coordinator_clear_buffer(coordinator);
 
     return status;
 }
@@ -592,23 +869,135 @@ cleanup:
     return status;
 }
 
-enum Voting_Coordinator_status
-Voting_Coordinator_import_encrypted_ballots(Voting_Coordinator coordinator, 
-                                            uint64_t start_index, 
-                                            uint64_t count,
-                                            uint32_t num_selections,
-                                            FILE *in,
-                                            char **out_external_identifiers,
-                                            struct register_ballot_message *out_messages)
+// Import ballots from a binary ballot file, where start_index counts records
+static enum Voting_Coordinator_status
+Voting_Coordinator_import_binary_ballots(uint64_t start_index, 
+                                         uint64_t count,
+                                         uint32_t num_selections,
+                                         FILE *in,
+                                         char **out_external_identifiers,
+                                         struct register_ballot_message *out_messages)
 {
     enum Voting_Coordinator_status status = VOTING_COORDINATOR_SUCCESS;
 
-    // start at the index
-    if (in == NULL || fseek(in, start_index, SEEK_SET) != 0) {
-        status = VOTING_COORDINATOR_IO_ERROR;
-        return status;
+    struct ballot_record record;
+    switch (Ballot_Record_open(&record, in))
+    {
+    case BALLOT_RECORD_SUCCESS:
+        break;
+    case BALLOT_RECORD_INSUFFICIENT_MEMORY:
+        return VOTING_COORDINATOR_INSUFFICIENT_MEMORY;
+    case BALLOT_RECORD_MALFORMED:
+        return VOTING_COORDINATOR_INVALID_DATA;
+    default:
+        return VOTING_COORDINATOR_IO_ERROR;
     }
 
+    if (record.header.num_selections != num_selections)
+        status = VOTING_COORDINATOR_INVALID_DATA;
+
+    struct encryption_rep *selections =
+        malloc(num_selections * sizeof(struct encryption_rep));
+    if (selections == NULL)
+        status = VOTING_COORDINATOR_INSUFFICIENT_MEMORY;
+    else
+        for (uint32_t j = 0; j < num_selections; j++)
+            Crypto_encryption_rep_new(&selections[j]);
+
+    for (uint64_t i = 0; i < count && status == VOTING_COORDINATOR_SUCCESS; i++)
+    {
+        if (start_index + i >= record.header.num_records)
+        {
+            status = VOTING_COORDINATOR_END_OF_FILE;
+            break;
+        }
+
+        out_external_identifiers[i] = malloc(MAX_EXTERNAL_ID_LENGTH + 1);
+        if (out_external_identifiers[i] == NULL)
+        {
+            status = VOTING_COORDINATOR_INSUFFICIENT_MEMORY;
+            break;
+        }
+        Ballot_Record_external_id(&record, start_index + i,
+                                  out_external_identifiers[i]);
+        Ballot_Record_selections(&record, start_index + i, selections);
+
+        // reconstruct the original register_ballot_message
+        struct encrypted_ballot_rep encrypted_ballot = {
+            .id = Ballot_Record_id(&record, start_index + i),
+            .num_selections = num_selections,
+            .selections = selections,
+        };
+
+        struct serialize_state state = {
+            .status = SERIALIZE_STATE_RESERVING,
+            .len = 0,
+            .offset = 0,
+            .buf = NULL
+        };
+
+        Serialize_reserve_encrypted_ballot(&state, &encrypted_ballot);
+        Serialize_allocate(&state);
+        Serialize_write_encrypted_ballot(&state, &encrypted_ballot);
+
+        if (state.status != SERIALIZE_STATE_WRITING)
+            status = VOTING_COORDINATOR_SERIALIZE_ERROR;
+        else
+            out_messages[i] = (struct register_ballot_message){
+                .len = state.len,
+                .bytes = state.buf,
+            };
+    }
+
+    if (selections != NULL)
+    {
+        for (uint32_t j = 0; j < num_selections; j++)
+            Crypto_encryption_rep_free(&selections[j]);
+        free(selections);
+    }
+
+    Ballot_Record_close(&record);
+
+    return status;
+}
+
+// Move in past the next num_ballots ballots of a text ballot file, each
+// on its own line
+static enum Voting_Coordinator_status
+Voting_Coordinator_skip_ballots(FILE *in, uint64_t num_ballots)
+{
+    bool in_ballot = false;
+    while (num_ballots > 0)
+    {
+        int c = fgetc(in);
+        if (c == EOF)
+            return VOTING_COORDINATOR_END_OF_FILE;
+
+        if (c == '\n')
+        {
+            if (in_ballot)
+                num_ballots--;
+            in_ballot = false;
+        }
+        else if (c != '\r')
+            in_ballot = true;
+    }
+
+    return VOTING_COORDINATOR_SUCCESS;
+}
+
+// Import ballots from the current position of a text ballot file, where
+// ballot start_index begins
+static enum Voting_Coordinator_status
+Voting_Coordinator_import_text_ballots(uint64_t start_index, 
+                                       uint64_t count,
+                                       uint32_t num_selections,
+                                       FILE *in,
+                                       char **out_external_identifiers,
+                                       struct register_ballot_message *out_messages)
+{
+    enum Voting_Coordinator_status status = VOTING_COORDINATOR_SUCCESS;
+
     DEBUG_PRINT(("Voting_Coordinator_import_encrypted_ballots: attempting to import: %ld\n", count));
 
     int scanResult = 0;
@@ -646,7 +1035,7 @@ Voting_Coordinator_import_encrypted_ballots(Voting_Coordinator coordinator,
         // reconstruct the original register_ballot_message
         struct encrypted_ballot_rep encrypted_ballot;
         struct Crypto_encrypted_ballot_new_r result =
-            Crypto_encrypted_ballot_new(num_selections, i);
+            Crypto_encrypted_ballot_new(num_selections, start_index + i);
         encrypted_ballot = result.result;
 
         // TODO: check/convert status from result
@@ -676,7 +1065,7 @@ Voting_Coordinator_import_encrypted_ballots(Voting_Coordinator coordinator,
                 .bytes = state.buf,
             };
 
-            out_messages[start_index + scanResult] = scanned_message;
+            out_messages[scanResult] = scanned_message;
         }
 
         // clean up
@@ -696,3 +1085,52 @@ Voting_Coordinator_import_encrypted_ballots(Voting_Coordinator coordinator,
     return status;
 
 }
+
+enum Voting_Coordinator_status
+Voting_Coordinator_import_encrypted_ballots(Voting_Coordinator coordinator, 
+                                            uint64_t start_index, 
+                                            uint64_t count,
+                                            uint32_t num_selections,
+                                            FILE *in,
+                                            char **out_external_identifiers,
+                                            struct register_ballot_message *out_messages)
+{
+    enum Voting_Coordinator_status status = VOTING_COORDINATOR_SUCCESS;
+
+    if (in == NULL || fseek(in, 0L, SEEK_SET) != 0)
+        return VOTING_COORDINATOR_IO_ERROR;
+
+    // Binary files are read through a map of the whole file
+    if (Ballot_Record_is_binary(in))
+        return Voting_Coordinator_import_binary_ballots(
+            start_index, count, num_selections, in, out_external_identifiers,
+            out_messages);
+
+    // Without an index, the ballots before start_index are read past
+    status = Voting_Coordinator_skip_ballots(in, start_index);
+
+    if (status == VOTING_COORDINATOR_SUCCESS)
+        status = Voting_Coordinator_import_text_ballots(
+            start_index, count, num_selections, in, out_external_identifiers,
+            out_messages);
+
+    return status;
+}
+
+enum Voting_Coordinator_status
+Voting_Coordinator_import_encrypted_ballots_at(Voting_Coordinator coordinator, 
+                                               uint64_t start_index, 
+                                               uint64_t offset,
+                                               uint64_t count,
+                                               uint32_t num_selections,
+                                               FILE *in,
+                                               char **out_external_identifiers,
+                                               struct register_ballot_message *out_messages)
+{
+    if (in == NULL || offset > LONG_MAX || fseek(in, (long)offset, SEEK_SET) != 0)
+        return VOTING_COORDINATOR_IO_ERROR;
+
+    return Voting_Coordinator_import_text_ballots(
+        start_index, count, num_selections, in, out_external_identifiers,
+        out_messages);
+}
@@ -1,28 +1,78 @@
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <electionguard/voting/encrypter.h>
 #include <electionguard/secure_zero_memory.h>
 
+#include "ballot_record.h"
 #include "crypto_reps.h"
 #include "random_source.h"
 #include "serialize/crypto.h"
 #include "serialize/state.h"
 #include "serialize/voting.h"
 #include "sha2-openbsd.h"
+#include "sha256_accel.h"
 #include "voting/message_reps.h"
 
-// count of ballots encrypted with this encrypter
-uint64_t _encrypted_ballot_count = 0;
+// count of ballots encrypted with this encrypter. Ballots may be encrypted
+// from several threads at once, so ids are reserved atomically.
+_Atomic uint64_t _encrypted_ballot_count = 0;
+
+// Number of selections of a ballot encrypted as one unit of parallel work
+#define VOTING_ENCRYPTER_SELECTION_CHUNK 8
+
+// Number of ballots whose trackers are hashed together, one per lane of
+// SHA256_multi
+#define VOTING_ENCRYPTER_TRACKER_CHUNK 8
+
+// Number of ballots of a proofs file whose proofs are checked together
+#define VOTING_ENCRYPTER_AUDIT_CHUNK 64
+
+// Encryptions precomputed by a background thread, which keeps num_ready of
+// them ready until told to stop. Guarded by lock; the thread waits on
+// wanted while the pool is full.
+struct Voting_Encrypter_precomputed
+{
+    pthread_mutex_t lock;
+    pthread_cond_t wanted;
+    struct Crypto_encryption_precomputation *ready;
+    uint32_t capacity;
+    uint32_t num_ready;
+    bool stopping;
+    pthread_t thread;
+};
+
+// A ballot whose proofs are left for Voting_Encrypter_verify_deferred
+struct Voting_Encrypter_deferred_ballot
+{
+    struct encrypted_ballot_rep ballot;
+    uint32_t expected_num_selected;
+};
 
 struct Voting_Encrypter_s
 {
     struct uid uid;
     struct joint_public_key_rep joint_key;
+    // precomputed powers of the generator and the joint key
+    struct Crypto_fixed_bases bases;
     uint32_t num_selections;
     struct hash base_hash;
     RandomSource source;
+    // NULL unless precomputing in the background
+    struct Voting_Encrypter_precomputed *precomputed;
+    enum Crypto_verification_policy verification_policy;
+    // ballots made under CRYPTO_VERIFY_DEFERRED and not yet checked
+    pthread_mutex_t deferred_lock;
+    struct Voting_Encrypter_deferred_ballot *deferred;
+    size_t num_deferred;
+    size_t deferred_capacity;
+    // where the proofs of each ballot are written, if anywhere; guarded by
+    // proofs_lock
+    pthread_mutex_t proofs_lock;
+    FILE *proofs_file;
 };
 
 enum Voting_Encrypter_status
@@ -57,6 +107,9 @@ Voting_Encrypter_serialize_read_status_convert(enum serialize_status status)
     }
 }
 
+static enum Voting_Encrypter_status
+Voting_Encrypter_Crypto_status_convert(enum Crypto_status status);
+
 struct Voting_Encrypter_new_r
 Voting_Encrypter_new(struct uid uid, struct joint_public_key joint_key,
                      uint32_t num_selections, raw_hash base_hash)
@@ -107,6 +160,16 @@ Voting_Encrypter_new(struct uid uid, struct joint_public_key joint_key,
             Voting_Encrypter_serialize_read_status_convert(state.status);
     }
 
+    // Precompute the fixed bases every selection is encrypted under
+    bool bases_built = false;
+    if (result.status == VOTING_ENCRYPTER_SUCCESS)
+    {
+        result.status = Voting_Encrypter_Crypto_status_convert(
+            Crypto_fixed_bases_new(&result.encrypter->bases,
+                                   result.encrypter->joint_key.public_key));
+        bases_built = result.status == VOTING_ENCRYPTER_SUCCESS;
+    }
+
     // Get a random source
     RandomSource source = NULL;
     if (result.status == VOTING_ENCRYPTER_SUCCESS)
@@ -122,6 +185,9 @@ Voting_Encrypter_new(struct uid uid, struct joint_public_key joint_key,
 
     if (result.status == VOTING_ENCRYPTER_SUCCESS)
     {
+        result.encrypter->verification_policy = CRYPTO_VERIFY_ALWAYS;
+        pthread_mutex_init(&result.encrypter->deferred_lock, NULL);
+        pthread_mutex_init(&result.encrypter->proofs_lock, NULL);
         result.encrypter->num_selections = num_selections;
         mpz_init(result.encrypter->base_hash.digest);
         Crypto_hash_reduce(&result.encrypter->base_hash, base_hash);
@@ -131,6 +197,8 @@ Voting_Encrypter_new(struct uid uid, struct joint_public_key joint_key,
     {
         if (NULL != source)
             RandomSource_free(source);
+        if (bases_built)
+            Crypto_fixed_bases_free(&result.encrypter->bases);
         if (NULL != uid_buf)
             free(uid_buf);
         if (NULL != result.encrypter)
@@ -142,13 +210,20 @@ Voting_Encrypter_new(struct uid uid, struct joint_public_key joint_key,
 
 void Voting_Encrypter_free(Voting_Encrypter encrypter)
 {
+    Voting_Encrypter_stop_precomputing(encrypter);
+    for (size_t i = 0; i < encrypter->num_deferred; i++)
+        Crypto_encrypted_ballot_free(&encrypter->deferred[i].ballot);
+    free(encrypter->deferred);
+    pthread_mutex_destroy(&encrypter->deferred_lock);
+    pthread_mutex_destroy(&encrypter->proofs_lock);
     free((void *)encrypter->uid.bytes);
     RandomSource_free(encrypter->source);
+    Crypto_fixed_bases_free(&encrypter->bases);
     Crypto_joint_public_key_free(&encrypter->joint_key);
     free((void *)encrypter);
 }
 
-enum Voting_Encrypter_status
+static enum Voting_Encrypter_status
 Voting_Encrypter_Crypto_status_convert(enum Crypto_status status)
 {
     switch (status)
@@ -164,6 +239,251 @@ Voting_Encrypter_Crypto_status_convert(enum Crypto_status status)
     }
 }
 
+static void *Voting_Encrypter_precompute_thread(void *arg)
+{
+    Voting_Encrypter encrypter = arg;
+    struct Voting_Encrypter_precomputed *precomputed = encrypter->precomputed;
+
+    // The encrypter's own source belongs to the thread encrypting ballots
+    struct RandomSource_new_r rs = RandomSource_new();
+    if (rs.status != RANDOM_SOURCE_SUCCESS)
+        return NULL;
+
+    struct Crypto_encryption_precomputation next;
+    Crypto_encryption_precomputation_new(&next);
+
+    pthread_mutex_lock(&precomputed->lock);
+    while (!precomputed->stopping)
+    {
+        if (precomputed->num_ready == precomputed->capacity)
+        {
+            pthread_cond_wait(&precomputed->wanted, &precomputed->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&precomputed->lock);
+        Crypto_encryption_precompute(&next, rs.source,
+                                     encrypter->joint_key.public_key,
+                                     &encrypter->bases);
+        pthread_mutex_lock(&precomputed->lock);
+
+        if (precomputed->num_ready < precomputed->capacity)
+            Crypto_encryption_precomputation_swap(
+                &next, &precomputed->ready[precomputed->num_ready++]);
+    }
+    pthread_mutex_unlock(&precomputed->lock);
+
+    Crypto_encryption_precomputation_free(&next);
+    RandomSource_free(rs.source);
+    return NULL;
+}
+
+enum Voting_Encrypter_status
+Voting_Encrypter_start_precomputing(Voting_Encrypter encrypter,
+                                    uint32_t pool_size)
+{
+    if (encrypter->precomputed != NULL)
+        return VOTING_ENCRYPTER_SUCCESS;
+
+    enum Voting_Encrypter_status status = VOTING_ENCRYPTER_SUCCESS;
+
+    struct Voting_Encrypter_precomputed *precomputed =
+        malloc(sizeof(struct Voting_Encrypter_precomputed));
+    struct Crypto_encryption_precomputation *ready =
+        malloc(pool_size * sizeof(struct Crypto_encryption_precomputation));
+    if (precomputed == NULL || ready == NULL || pool_size == 0)
+        status = VOTING_ENCRYPTER_INSUFFICIENT_MEMORY;
+
+    if (status == VOTING_ENCRYPTER_SUCCESS)
+    {
+        for (uint32_t i = 0; i < pool_size; i++)
+            Crypto_encryption_precomputation_new(&ready[i]);
+
+        *precomputed = (struct Voting_Encrypter_precomputed){
+            .ready = ready,
+            .capacity = pool_size,
+            .num_ready = 0,
+            .stopping = false,
+        };
+        pthread_mutex_init(&precomputed->lock, NULL);
+        pthread_cond_init(&precomputed->wanted, NULL);
+
+        encrypter->precomputed = precomputed;
+        if (0 != pthread_create(&precomputed->thread, NULL,
+                                Voting_Encrypter_precompute_thread, encrypter))
+        {
+            encrypter->precomputed = NULL;
+            pthread_cond_destroy(&precomputed->wanted);
+            pthread_mutex_destroy(&precomputed->lock);
+            for (uint32_t i = 0; i < pool_size; i++)
+                Crypto_encryption_precomputation_free(&ready[i]);
+            status = VOTING_ENCRYPTER_UNKNOWN_ERROR;
+        }
+    }
+
+    if (status != VOTING_ENCRYPTER_SUCCESS)
+    {
+        free(ready);
+        free(precomputed);
+    }
+
+    return status;
+}
+
+void Voting_Encrypter_stop_precomputing(Voting_Encrypter encrypter)
+{
+    struct Voting_Encrypter_precomputed *precomputed = encrypter->precomputed;
+    if (precomputed == NULL)
+        return;
+
+    pthread_mutex_lock(&precomputed->lock);
+    precomputed->stopping = true;
+    pthread_cond_signal(&precomputed->wanted);
+    pthread_mutex_unlock(&precomputed->lock);
+    pthread_join(precomputed->thread, NULL);
+
+    encrypter->precomputed = NULL;
+    pthread_cond_destroy(&precomputed->wanted);
+    pthread_mutex_destroy(&precomputed->lock);
+    for (uint32_t i = 0; i < precomputed->capacity; i++)
+        Crypto_encryption_precomputation_free(&precomputed->ready[i]);
+    free(precomputed->ready);
+    free(precomputed);
+}
+
+// Get the exponentiations for one encryption: from the background thread
+// if it has any ready, otherwise computed here
+static void
+Voting_Encrypter_take_precomputation(Voting_Encrypter encrypter,
+                                     RandomSource source,
+                                     struct Crypto_encryption_precomputation *out)
+{
+    struct Voting_Encrypter_precomputed *precomputed = encrypter->precomputed;
+    bool taken = false;
+
+    if (precomputed != NULL)
+    {
+        pthread_mutex_lock(&precomputed->lock);
+        if (precomputed->num_ready > 0)
+        {
+            Crypto_encryption_precomputation_swap(
+                out, &precomputed->ready[--precomputed->num_ready]);
+            pthread_cond_signal(&precomputed->wanted);
+            taken = true;
+        }
+        pthread_mutex_unlock(&precomputed->lock);
+    }
+
+    if (!taken)
+        Crypto_encryption_precompute(out, source,
+                                     encrypter->joint_key.public_key,
+                                     &encrypter->bases);
+}
+
+void Voting_Encrypter_set_verification_policy(
+    Voting_Encrypter encrypter, enum Crypto_verification_policy policy)
+{
+    encrypter->verification_policy = policy;
+}
+
+// Check the proofs of a finished ballot, whose selections sum to tally
+static bool Voting_Encrypter_check_ballot(Voting_Encrypter encrypter,
+                                          RandomSource source,
+                                          struct encrypted_ballot_rep *ballot,
+                                          struct encryption_rep tally,
+                                          uint32_t expected_num_selected)
+{
+    // Check all of the ballot's selection proofs together, which is sound
+    // only because this encrypter made them
+    return Crypto_batch_check_own_dis_proofs(
+               ballot->dis_proof, ballot->selections, encrypter->num_selections,
+               encrypter->base_hash, encrypter->joint_key.public_key,
+               &encrypter->bases, source, NULL) &&
+           Crypto_check_aggregate_cp_proof(ballot->cp_proof, tally,
+                                           encrypter->base_hash,
+                                           encrypter->joint_key.public_key,
+                                           &encrypter->bases,
+                                           expected_num_selected);
+}
+
+// Keep a ballot to be checked by Voting_Encrypter_verify_deferred, taking
+// ownership of it
+static bool Voting_Encrypter_defer_ballot(Voting_Encrypter encrypter,
+                                          struct encrypted_ballot_rep *ballot,
+                                          uint32_t expected_num_selected)
+{
+    bool ok = true;
+    pthread_mutex_lock(&encrypter->deferred_lock);
+
+    if (encrypter->num_deferred == encrypter->deferred_capacity)
+    {
+        size_t capacity = encrypter->deferred_capacity == 0
+                              ? 16
+                              : 2 * encrypter->deferred_capacity;
+        struct Voting_Encrypter_deferred_ballot *deferred =
+            realloc(encrypter->deferred,
+                    capacity * sizeof(struct Voting_Encrypter_deferred_ballot));
+        if (deferred == NULL)
+            ok = false;
+        else
+        {
+            encrypter->deferred = deferred;
+            encrypter->deferred_capacity = capacity;
+        }
+    }
+
+    if (ok)
+    {
+        encrypter->deferred[encrypter->num_deferred++] =
+            (struct Voting_Encrypter_deferred_ballot){
+                .ballot = *ballot,
+                .expected_num_selected = expected_num_selected,
+            };
+    }
+
+    pthread_mutex_unlock(&encrypter->deferred_lock);
+    return ok;
+}
+
+enum Voting_Encrypter_status
+Voting_Encrypter_verify_deferred(Voting_Encrypter encrypter)
+{
+    pthread_mutex_lock(&encrypter->deferred_lock);
+    struct Voting_Encrypter_deferred_ballot *deferred = encrypter->deferred;
+    size_t num_deferred = encrypter->num_deferred;
+    encrypter->deferred = NULL;
+    encrypter->num_deferred = 0;
+    encrypter->deferred_capacity = 0;
+    pthread_mutex_unlock(&encrypter->deferred_lock);
+
+    enum Voting_Encrypter_status status = VOTING_ENCRYPTER_SUCCESS;
+
+    struct encryption_rep tally;
+    Crypto_encryption_rep_new(&tally);
+
+    for (size_t i = 0; i < num_deferred; i++)
+    {
+        struct encrypted_ballot_rep *ballot = &deferred[i].ballot;
+
+        Crypto_encryption_homomorphic_zero(&tally);
+        for (uint32_t j = 0; j < encrypter->num_selections; j++)
+            Crypto_encryption_homomorphic_add(&tally, &tally,
+                                              &ballot->selections[j]);
+
+        if (!Voting_Encrypter_check_ballot(encrypter, encrypter->source, ballot,
+                                           tally,
+                                           deferred[i].expected_num_selected))
+            status = VOTING_ENCRYPTER_UNKNOWN_ERROR;
+
+        Crypto_encrypted_ballot_free(ballot);
+    }
+
+    Crypto_encryption_rep_free(&tally);
+    free(deferred);
+
+    return status;
+}
+
 bool Validate_selections(bool const *selections, uint32_t num_selections, uint32_t expected_num_selected)
 {
     uint32_t count = 0;
@@ -175,27 +495,242 @@ bool Validate_selections(bool const *selections, uint32_t num_selections, uint32
     return count == expected_num_selected ? true : false;
 }
 
-struct Voting_Encrypter_encrypt_ballot_r
-Voting_Encrypter_encrypt_ballot(Voting_Encrypter encrypter,
-                                char *external_identifier,
-                                bool const *selections,
-                                uint32_t expected_num_selected)
+// Write the values of a tuple of a proofs file: (v0,v1,...)
+static bool Voting_Encrypter_print_tuple(FILE *out, mpz_srcptr const *values,
+                                         uint32_t num_values)
+{
+    bool ok = fputc('(', out) != EOF;
+    for (uint32_t i = 0; i < num_values && ok; i++)
+        ok = (i == 0 || fputc(',', out) != EOF) && mpz_t_fprint(out, values[i]);
+    return ok && fputc(')', out) != EOF;
+}
+
+// Read the values of a tuple written by Voting_Encrypter_print_tuple
+static bool Voting_Encrypter_scan_tuple(FILE *in, mpz_ptr const *values,
+                                        uint32_t num_values)
+{
+    bool ok = fscanf(in, " (") == 0;
+    for (uint32_t i = 0; i < num_values && ok; i++)
+        ok = (i == 0 || fgetc(in) == ',') && mpz_t_fscan(in, values[i]);
+    return ok && fgetc(in) == ')';
+}
+
+// The challenge of a proof is not written, being c0 + c1
+#define VOTING_ENCRYPTER_PROOF_VALUES 8
+
+// Write a line of the proofs file for ballot:
+//     <external_id> TAB (TAB <encryption> TAB <proof>)* \n
+static enum Voting_Encrypter_status
+Voting_Encrypter_write_proofs(Voting_Encrypter encrypter,
+                              char *external_identifier,
+                              struct encrypted_ballot_rep *ballot)
+{
+    pthread_mutex_lock(&encrypter->proofs_lock);
+    FILE *out = encrypter->proofs_file;
+
+    bool ok = fprintf(out, "%s\t", external_identifier) >= 0;
+    for (uint32_t i = 0; i < ballot->num_selections && ok; i++)
+    {
+        struct encryption_rep *encryption = &ballot->selections[i];
+        struct dis_proof_rep *proof = &ballot->dis_proof[i];
+        mpz_srcptr encryption_values[2] = {encryption->nonce_encoding,
+                                           encryption->message_encoding};
+        mpz_srcptr proof_values[VOTING_ENCRYPTER_PROOF_VALUES] = {
+            proof->commitment0.nonce_encoding,
+            proof->commitment0.message_encoding,
+            proof->commitment1.nonce_encoding,
+            proof->commitment1.message_encoding,
+            proof->challenge0,
+            proof->challenge1,
+            proof->response0,
+            proof->response1,
+        };
+
+        ok = fputc('\t', out) != EOF &&
+             Voting_Encrypter_print_tuple(out, encryption_values, 2) &&
+             fputc('\t', out) != EOF &&
+             Voting_Encrypter_print_tuple(out, proof_values,
+                                          VOTING_ENCRYPTER_PROOF_VALUES);
+    }
+    ok = ok && fputc('\n', out) != EOF;
+
+    pthread_mutex_unlock(&encrypter->proofs_lock);
+    return ok ? VOTING_ENCRYPTER_SUCCESS : VOTING_ENCRYPTER_IO_ERROR;
+}
+
+void Voting_Encrypter_set_proofs_file(Voting_Encrypter encrypter, FILE *out)
+{
+    pthread_mutex_lock(&encrypter->proofs_lock);
+    encrypter->proofs_file = out;
+    pthread_mutex_unlock(&encrypter->proofs_lock);
+}
+
+// Read the next line of a proofs file into the encryptions and proofs of
+// its selections. Returns VOTING_ENCRYPTER_SUCCESS with *out_read false at
+// the end of the file.
+static enum Voting_Encrypter_status
+Voting_Encrypter_read_proofs(FILE *in, uint32_t num_selections,
+                             struct encryption_rep *encryptions,
+                             struct dis_proof_rep *proofs, bool *out_read)
+{
+    *out_read = false;
+
+    // The external identifier is not needed
+    int scanned = fscanf(in, "%*s");
+    if (scanned == EOF)
+        return feof(in) ? VOTING_ENCRYPTER_SUCCESS : VOTING_ENCRYPTER_IO_ERROR;
+
+    bool ok = true;
+    for (uint32_t i = 0; i < num_selections && ok; i++)
+    {
+        struct dis_proof_rep *proof = &proofs[i];
+        mpz_ptr encryption_values[2] = {encryptions[i].nonce_encoding,
+                                        encryptions[i].message_encoding};
+        mpz_ptr proof_values[VOTING_ENCRYPTER_PROOF_VALUES] = {
+            proof->commitment0.nonce_encoding,
+            proof->commitment0.message_encoding,
+            proof->commitment1.nonce_encoding,
+            proof->commitment1.message_encoding,
+            proof->challenge0,
+            proof->challenge1,
+            proof->response0,
+            proof->response1,
+        };
+
+        ok = Voting_Encrypter_scan_tuple(in, encryption_values, 2) &&
+             Voting_Encrypter_scan_tuple(in, proof_values,
+                                         VOTING_ENCRYPTER_PROOF_VALUES);
+        if (ok)
+            add_mod_q(proof->challenge.digest, proof->challenge0,
+                      proof->challenge1);
+    }
+
+    *out_read = ok;
+    return ok ? VOTING_ENCRYPTER_SUCCESS : VOTING_ENCRYPTER_DESERIALIZE_ERROR;
+}
+
+enum Voting_Encrypter_status
+Voting_Encrypter_audit_proofs(Voting_Encrypter encrypter, FILE *in,
+                              uint64_t *out_num_ballots,
+                              uint64_t *out_num_invalid)
+{
+    enum Voting_Encrypter_status status = VOTING_ENCRYPTER_SUCCESS;
+    const uint32_t num_selections = encrypter->num_selections;
+    const uint32_t num_proofs = VOTING_ENCRYPTER_AUDIT_CHUNK * num_selections;
+
+    *out_num_ballots = 0;
+    *out_num_invalid = 0;
+
+    struct encryption_rep *encryptions =
+        malloc(num_proofs * sizeof(struct encryption_rep));
+    struct dis_proof_rep *proofs =
+        malloc(num_proofs * sizeof(struct dis_proof_rep));
+    bool *valid = malloc(num_proofs * sizeof(bool));
+    if (encryptions == NULL || proofs == NULL || valid == NULL)
+        status = VOTING_ENCRYPTER_INSUFFICIENT_MEMORY;
+
+    for (uint32_t i = 0; i < num_proofs && status == VOTING_ENCRYPTER_SUCCESS;
+         i++)
+    {
+        Crypto_encryption_rep_new(&encryptions[i]);
+        Crypto_dis_proof_new(&proofs[i]);
+    }
+
+    bool more = true;
+    while (status == VOTING_ENCRYPTER_SUCCESS && more)
+    {
+        uint32_t num_ballots = 0;
+        while (status == VOTING_ENCRYPTER_SUCCESS && more &&
+               num_ballots < VOTING_ENCRYPTER_AUDIT_CHUNK)
+        {
+            uint32_t first = num_ballots * num_selections;
+            status = Voting_Encrypter_read_proofs(in, num_selections,
+                                                  &encryptions[first],
+                                                  &proofs[first], &more);
+            if (more)
+                num_ballots++;
+        }
+
+        if (status == VOTING_ENCRYPTER_SUCCESS && num_ballots > 0)
+        {
+            Crypto_batch_check_dis_proofs(
+                proofs, encryptions, num_ballots * num_selections,
+                encrypter->base_hash, encrypter->joint_key.public_key,
+                &encrypter->bases, encrypter->source, valid);
+
+            for (uint32_t b = 0; b < num_ballots; b++)
+            {
+                bool ballot_valid = true;
+                for (uint32_t j = 0; j < num_selections; j++)
+                    ballot_valid &= valid[b * num_selections + j];
+                if (!ballot_valid)
+                    (*out_num_invalid)++;
+            }
+            *out_num_ballots += num_ballots;
+        }
+    }
+
+    if (encryptions != NULL && proofs != NULL && valid != NULL)
+        for (uint32_t i = 0; i < num_proofs; i++)
+        {
+            Crypto_encryption_rep_free(&encryptions[i]);
+            Crypto_dis_proof_free(&proofs[i]);
+        }
+    free(encryptions);
+    free(proofs);
+    free(valid);
+
+    return status;
+}
+
+// A ballot part way through encryption. Selections may be encrypted on
+// different threads, so the nonce of each one is kept until the ballot is
+// finished and they are summed for the aggregate proof.
+struct Voting_Encrypter_ballot_job
+{
+    char *external_identifier;
+    bool const *selections;
+    uint32_t expected_num_selected;
+    bool ballot_allocated;
+    // whether the ballot's proofs are left for Voting_Encrypter_verify_deferred
+    bool deferred;
+    struct encrypted_ballot_rep ballot;
+    mpz_t *nonces;
+    struct Voting_Encrypter_encrypt_ballot_r result;
+};
+
+// Validate the selections and allocate the ballot id and representation
+static void
+Voting_Encrypter_ballot_job_begin(Voting_Encrypter encrypter,
+                                  struct Voting_Encrypter_ballot_job *job)
 {
     // TODO: associate the external_identifier with the internal one, possibly via hash
-    
-    uint64_t internal_ballot_id = _encrypted_ballot_count;
-    struct Voting_Encrypter_encrypt_ballot_r ballot_result;
-    ballot_result.status = VOTING_ENCRYPTER_SUCCESS;
+
+    job->ballot_allocated = false;
+    job->deferred = false;
+    job->nonces = NULL;
+    job->result = (struct Voting_Encrypter_encrypt_ballot_r){
+        .status = VOTING_ENCRYPTER_SUCCESS,
+        .message = {.bytes = NULL},
+        .tracker = {.bytes = NULL},
+        .id = {.bytes = NULL},
+    };
 
     // validate selection
-    if (!Validate_selections(selections, encrypter->num_selections, expected_num_selected))
+    if (!Validate_selections(job->selections, encrypter->num_selections,
+                             job->expected_num_selected))
     {
-        ballot_result.status = VOTING_ENCRYPTER_SELECTION_ERROR;
+        job->result.status = VOTING_ENCRYPTER_SELECTION_ERROR;
     }
 
+    // Reserve an id. A ballot that fails after this point leaves a gap
+    uint64_t internal_ballot_id = 0;
+    if (job->result.status == VOTING_ENCRYPTER_SUCCESS)
+        internal_ballot_id = atomic_fetch_add(&_encrypted_ballot_count, 1);
+
     // TODO: refactor this since this block exists in record_ballots.c
     // Construct the ballot id
-    if (ballot_result.status == VOTING_ENCRYPTER_SUCCESS)
+    if (job->result.status == VOTING_ENCRYPTER_SUCCESS)
     {
         struct ballot_identifier_rep rep = {
             .id = internal_ballot_id
@@ -214,11 +749,11 @@ Voting_Encrypter_encrypt_ballot(Voting_Encrypter encrypter,
 
         if (state.status != SERIALIZE_STATE_WRITING)
         {
-            ballot_result.status = VOTING_ENCRYPTER_SERIALIZE_ERROR;
+            job->result.status = VOTING_ENCRYPTER_SERIALIZE_ERROR;
         }
         else
         {
-            ballot_result.id = (struct ballot_identifier)
+            job->result.id = (struct ballot_identifier)
             {
                 .len = state.len,
                 .bytes = state.buf,
@@ -228,87 +763,132 @@ Voting_Encrypter_encrypt_ballot(Voting_Encrypter encrypter,
 
     // Construct the message
     // TODO: refactor this out as it is similar to the one in coordinator.c
-    struct encrypted_ballot_rep encrypted_ballot;
-    if (ballot_result.status == VOTING_ENCRYPTER_SUCCESS)
+    if (job->result.status == VOTING_ENCRYPTER_SUCCESS)
     {
-        // TODO: verify that _encrypted_ballot_count can be duplicated in a single file
-        // but not in a single instance
         struct Crypto_encrypted_ballot_new_r temp_result =
             Crypto_encrypted_ballot_new(encrypter->num_selections,
                                         internal_ballot_id);
-        encrypted_ballot = temp_result.result;
+        job->ballot = temp_result.result;
 
         // TODO: use this pattern for swith/case conversions?
-        ballot_result.status = Voting_Encrypter_Crypto_status_convert(temp_result.status);
+        job->result.status = Voting_Encrypter_Crypto_status_convert(temp_result.status);
+        job->ballot_allocated = job->result.status == VOTING_ENCRYPTER_SUCCESS;
     }
 
-    if (ballot_result.status == VOTING_ENCRYPTER_SUCCESS)
+    if (job->result.status == VOTING_ENCRYPTER_SUCCESS)
+    {
+        job->nonces = malloc(encrypter->num_selections * sizeof(mpz_t));
+        if (job->nonces == NULL)
+            job->result.status = VOTING_ENCRYPTER_INSUFFICIENT_MEMORY;
+        else
+            for (uint32_t i = 0; i < encrypter->num_selections; i++)
+                mpz_init(job->nonces[i]);
+    }
+}
+
+// Encrypt the selections in [begin, end) and prove each is 0 or 1. Jobs
+// that failed to begin are skipped.
+static void
+Voting_Encrypter_ballot_job_encrypt(Voting_Encrypter encrypter,
+                                    RandomSource source,
+                                    struct Voting_Encrypter_ballot_job *job,
+                                    uint32_t begin, uint32_t end)
+{
+    if (job->result.status != VOTING_ENCRYPTER_SUCCESS)
+        return;
+
+    struct Crypto_encryption_precomputation pre;
+    Crypto_encryption_precomputation_new(&pre);
+
+    for (uint32_t i = begin; i < end; i++)
+    {
+        Voting_Encrypter_take_precomputation(encrypter, source, &pre);
+
+        Crypto_encrypt_precomputed(
+            &job->ballot.selections[i],
+            job->nonces[i],
+            &pre,
+            job->selections[i]
+                ? generator /*g^1*/
+                : bignum_one /*g^0*/
+        );
+
+        Crypto_generate_dis_proof_precomputed(&job->ballot.dis_proof[i],
+                                              encrypter->base_hash,
+                                              job->selections[i],
+                                              &pre,
+                                              job->ballot.selections[i]);
+    }
+
+    Crypto_encryption_precomputation_free(&pre);
+}
+
+// Prove the number of selections made, check the proofs, then serialize
+// the ballot. Frees everything but the result.
+static void
+Voting_Encrypter_ballot_job_finish(Voting_Encrypter encrypter,
+                                   RandomSource source,
+                                   struct Voting_Encrypter_ballot_job *job)
+{
+    if (job->result.status == VOTING_ENCRYPTER_SUCCESS)
     {
         struct encryption_rep tally;
         Crypto_encryption_rep_new(&tally);
         Crypto_encryption_homomorphic_zero(&tally);
 
-        mpz_t nonce, aggregate_nonce;
-        mpz_init(nonce);
+        mpz_t aggregate_nonce;
         mpz_init(aggregate_nonce);
 
-        // encrypt the ballot
         for (uint32_t i = 0; i < encrypter->num_selections; i++)
         {
-            Crypto_encrypt(
-                &encrypted_ballot.selections[i], 
-                nonce, 
-                encrypter->source,
-                &encrypter->joint_key,
-                selections[i] 
-                    ? generator /*g^1*/ 
-                    : bignum_one /*g^0*/
-            );
-
             Crypto_encryption_homomorphic_add(
-                &tally, &tally, &encrypted_ballot.selections[i]);
-                
+                &tally, &tally, &job->ballot.selections[i]);
+
             if (i == 0)
             {
-                mpz_set(aggregate_nonce, nonce);
+                mpz_set(aggregate_nonce, job->nonces[i]);
             }
             else
             {
-                add_mod_q(aggregate_nonce, aggregate_nonce, nonce);
-            }
-
-            Crypto_generate_dis_proof(&encrypted_ballot.dis_proof[i],
-                                      encrypter->source,
-                                      encrypter->base_hash,
-                                      selections[i],
-                                      encrypter->joint_key.public_key,
-                                      encrypted_ballot.selections[i], 
-                                      nonce);
-            if (!Crypto_check_dis_proof(encrypted_ballot.dis_proof[i],
-                                        encrypted_ballot.selections[i],
-                                        encrypter->base_hash,
-                                        encrypter->joint_key.public_key))
-            {
-                ballot_result.status = VOTING_ENCRYPTER_UNKNOWN_ERROR;
+                add_mod_q(aggregate_nonce, aggregate_nonce, job->nonces[i]);
             }
         }
 
-        Crypto_generate_aggregate_cp_proof(
-            &encrypted_ballot.cp_proof, 
-            encrypter->source, aggregate_nonce,
+        struct Crypto_encryption_precomputation pre;
+        Crypto_encryption_precomputation_new(&pre);
+        Voting_Encrypter_take_precomputation(encrypter, source, &pre);
+        Crypto_generate_aggregate_cp_proof_precomputed(
+            &job->ballot.cp_proof,
+            aggregate_nonce,
             tally, encrypter->base_hash,
-            encrypter->joint_key.public_key
+            &pre
         );
+        Crypto_encryption_precomputation_free(&pre);
+
+        // Ballot ids are sequential, so sampling by id checks an even
+        // spread of ballots
+        bool check;
+        switch (encrypter->verification_policy)
+        {
+        case CRYPTO_VERIFY_SAMPLED:
+            check = job->ballot.id % CRYPTO_VERIFY_SAMPLE_RATE == 0;
+            break;
+        case CRYPTO_VERIFY_DEFERRED:
+            check = false;
+            job->deferred = true;
+            break;
+        default:
+            check = true;
+            break;
+        }
 
-        if (!Crypto_check_aggregate_cp_proof(encrypted_ballot.cp_proof, tally,
-                                             encrypter->base_hash,
-                                             encrypter->joint_key.public_key,
-                                             expected_num_selected))
+        if (check && !Voting_Encrypter_check_ballot(encrypter, source,
+                                                    &job->ballot, tally,
+                                                    job->expected_num_selected))
         {
-            ballot_result.status = VOTING_ENCRYPTER_UNKNOWN_ERROR;
+            job->result.status = VOTING_ENCRYPTER_UNKNOWN_ERROR;
         }
 
-        mpz_clear(nonce);
         mpz_clear(aggregate_nonce);
         Crypto_encryption_rep_free(&tally);
 
@@ -319,59 +899,287 @@ Voting_Encrypter_encrypt_ballot(Voting_Encrypter encrypter,
             .buf = NULL
         };
 
-        Serialize_reserve_encrypted_ballot(&state, &encrypted_ballot);
+        Serialize_reserve_encrypted_ballot(&state, &job->ballot);
         Serialize_allocate(&state);
-        Serialize_write_encrypted_ballot(&state, &encrypted_ballot);
+        Serialize_write_encrypted_ballot(&state, &job->ballot);
 
         if (state.status != SERIALIZE_STATE_WRITING)
-            ballot_result.status = VOTING_ENCRYPTER_SERIALIZE_ERROR;
+            job->result.status = VOTING_ENCRYPTER_SERIALIZE_ERROR;
         else
         {
-            ballot_result.message = (struct register_ballot_message)
+            job->result.message = (struct register_ballot_message)
             {
                 .len = state.len,
                 .bytes = state.buf,
             };
         }
+
+        if (job->result.status == VOTING_ENCRYPTER_SUCCESS &&
+            encrypter->proofs_file != NULL)
+            job->result.status = Voting_Encrypter_write_proofs(
+                encrypter, job->external_identifier, &job->ballot);
     }
-    else 
+    else
     {
         printf("Voting_Encrypter_encrypt_ballot: ERROR! encrypting ballot");
     }
 
-    // clear proofs and encrypted ballot
-    Crypto_encrypted_ballot_free(&encrypted_ballot);
+    // clear nonces, proofs and encrypted ballot
+    if (job->nonces != NULL)
+    {
+        for (uint32_t i = 0; i < encrypter->num_selections; i++)
+            mpz_clear(job->nonces[i]);
+        free(job->nonces);
+        job->nonces = NULL;
+    }
+    if (job->ballot_allocated && job->deferred &&
+        job->result.status == VOTING_ENCRYPTER_SUCCESS)
+    {
+        if (Voting_Encrypter_defer_ballot(encrypter, &job->ballot,
+                                          job->expected_num_selected))
+            job->ballot_allocated = false;
+        else
+            job->result.status = VOTING_ENCRYPTER_INSUFFICIENT_MEMORY;
+    }
+    if (job->ballot_allocated)
+    {
+        Crypto_encrypted_ballot_free(&job->ballot);
+        job->ballot_allocated = false;
+    }
+}
 
-    // TODO: clear temp_result
+// Construct the ballot trackers of up to VOTING_ENCRYPTER_TRACKER_CHUNK
+// finished jobs, hashing their messages together
+static void
+Voting_Encrypter_ballot_jobs_track(struct Voting_Encrypter_ballot_job *jobs,
+                                   uint32_t num_jobs)
+{
+    const uint8_t *messages[VOTING_ENCRYPTER_TRACKER_CHUNK];
+    size_t lens[VOTING_ENCRYPTER_TRACKER_CHUNK];
+    uint8_t digests[VOTING_ENCRYPTER_TRACKER_CHUNK][SHA256_DIGEST_LENGTH];
+    struct Voting_Encrypter_ballot_job *tracked[VOTING_ENCRYPTER_TRACKER_CHUNK];
+    uint32_t num_tracked = 0;
 
-    // Construct the ballot tracker
-    if (ballot_result.status == VOTING_ENCRYPTER_SUCCESS)
+    for (uint32_t i = 0; i < num_jobs; i++)
+        if (jobs[i].result.status == VOTING_ENCRYPTER_SUCCESS)
+        {
+            messages[num_tracked] = jobs[i].result.message.bytes;
+            lens[num_tracked] = jobs[i].result.message.len;
+            tracked[num_tracked] = &jobs[i];
+            num_tracked++;
+        }
+
+    SHA256_multi(num_tracked, messages, lens, digests);
+
+    for (uint32_t i = 0; i < num_tracked; i++)
     {
-        SHA2_CTX context;
         uint8_t *digest_buffer = malloc(sizeof(uint8_t) * SHA256_DIGEST_LENGTH);
 
         if (digest_buffer == NULL)
         {
             // handle insufficient memory error
-            ballot_result.status = VOTING_ENCRYPTER_INSUFFICIENT_MEMORY;
-            return ballot_result;
+            tracked[i]->result.status = VOTING_ENCRYPTER_INSUFFICIENT_MEMORY;
+            continue;
         }
 
-        SHA256Init(&context);
-        SHA256Update(&context, ballot_result.message.bytes, ballot_result.message.len);
-        SHA256Final(digest_buffer, &context);
-
-        ballot_result.tracker = (struct ballot_tracker)
+        memcpy(digest_buffer, digests[i], SHA256_DIGEST_LENGTH);
+        tracked[i]->result.tracker = (struct ballot_tracker)
         {
             .len = SHA256_DIGEST_LENGTH,
             .bytes = digest_buffer,
         };
     }
+}
+
+struct Voting_Encrypter_encrypt_ballot_r
+Voting_Encrypter_encrypt_ballot(Voting_Encrypter encrypter,
+                                char *external_identifier,
+                                bool const *selections,
+                                uint32_t expected_num_selected)
+{
+    struct Voting_Encrypter_ballot_job job = {
+        .external_identifier = external_identifier,
+        .selections = selections,
+        .expected_num_selected = expected_num_selected,
+    };
+
+    Voting_Encrypter_ballot_job_begin(encrypter, &job);
+    Voting_Encrypter_ballot_job_encrypt(encrypter, encrypter->source, &job, 0,
+                                        encrypter->num_selections);
+    Voting_Encrypter_ballot_job_finish(encrypter, encrypter->source, &job);
+    Voting_Encrypter_ballot_jobs_track(&job, 1);
+
+    return job.result;
+}
+
+// Work shared by the threads of Voting_Encrypter_encrypt_ballots_parallel.
+// Each ballot is cut into chunks of selections, and the threads first claim
+// chunks to encrypt, then, once all of those are done, whole ballots to
+// finish, and last chunks of ballots to track.
+enum Voting_Encrypter_phase
+{
+    VOTING_ENCRYPTER_ENCRYPTING,
+    VOTING_ENCRYPTER_FINISHING,
+    VOTING_ENCRYPTER_TRACKING,
+};
+
+struct Voting_Encrypter_pool
+{
+    Voting_Encrypter encrypter;
+    struct Voting_Encrypter_ballot_job *jobs;
+    uint32_t num_ballots;
+    uint32_t chunks_per_ballot;
+    enum Voting_Encrypter_phase phase;
+    atomic_uint next;
+};
+
+static void Voting_Encrypter_pool_run(struct Voting_Encrypter_pool *pool,
+                                      RandomSource source)
+{
+    Voting_Encrypter encrypter = pool->encrypter;
+    uint32_t num_items;
+    switch (pool->phase)
+    {
+    case VOTING_ENCRYPTER_FINISHING:
+        num_items = pool->num_ballots;
+        break;
+    case VOTING_ENCRYPTER_TRACKING:
+        num_items = (pool->num_ballots + VOTING_ENCRYPTER_TRACKER_CHUNK - 1) /
+                    VOTING_ENCRYPTER_TRACKER_CHUNK;
+        break;
+    default:
+        num_items = pool->num_ballots * pool->chunks_per_ballot;
+        break;
+    }
+
+    for (uint32_t item = atomic_fetch_add(&pool->next, 1); item < num_items;
+         item = atomic_fetch_add(&pool->next, 1))
+    {
+        if (pool->phase == VOTING_ENCRYPTER_FINISHING)
+        {
+            Voting_Encrypter_ballot_job_finish(encrypter, source,
+                                               &pool->jobs[item]);
+        }
+        else if (pool->phase == VOTING_ENCRYPTER_TRACKING)
+        {
+            uint32_t begin = item * VOTING_ENCRYPTER_TRACKER_CHUNK;
+            uint32_t end = begin + VOTING_ENCRYPTER_TRACKER_CHUNK;
+            if (end > pool->num_ballots)
+                end = pool->num_ballots;
+
+            Voting_Encrypter_ballot_jobs_track(&pool->jobs[begin],
+                                               end - begin);
+        }
+        else
+        {
+            uint32_t ballot = item / pool->chunks_per_ballot;
+            uint32_t begin = (item % pool->chunks_per_ballot) *
+                             VOTING_ENCRYPTER_SELECTION_CHUNK;
+            uint32_t end = begin + VOTING_ENCRYPTER_SELECTION_CHUNK;
+            if (end > encrypter->num_selections)
+                end = encrypter->num_selections;
+
+            Voting_Encrypter_ballot_job_encrypt(encrypter, source,
+                                                &pool->jobs[ballot], begin,
+                                                end);
+        }
+    }
+}
+
+static void *Voting_Encrypter_pool_thread(void *arg)
+{
+    // RandomSources are not thread safe, so each worker has its own. A
+    // worker without one leaves the work to the others.
+    struct RandomSource_new_r rs = RandomSource_new();
+    if (rs.status == RANDOM_SOURCE_SUCCESS)
+    {
+        Voting_Encrypter_pool_run(arg, rs.source);
+        RandomSource_free(rs.source);
+    }
 
-    if (ballot_result.status == VOTING_ENCRYPTER_SUCCESS)
-        _encrypted_ballot_count++;
+    return NULL;
+}
+
+// Run one phase on num_threads threads, the calling thread among them
+static void Voting_Encrypter_pool_fan_out(struct Voting_Encrypter_pool *pool,
+                                          pthread_t *threads,
+                                          uint32_t num_threads)
+{
+    atomic_store(&pool->next, 0);
 
-    return ballot_result;
+    uint32_t num_started = 0;
+    for (uint32_t i = 1; i < num_threads; i++)
+        if (0 == pthread_create(&threads[num_started], NULL,
+                                Voting_Encrypter_pool_thread, pool))
+            num_started++;
+
+    Voting_Encrypter_pool_run(pool, pool->encrypter->source);
+
+    for (uint32_t i = 0; i < num_started; i++)
+        pthread_join(threads[i], NULL);
+}
+
+enum Voting_Encrypter_status
+Voting_Encrypter_encrypt_ballots_parallel(
+    Voting_Encrypter encrypter, uint32_t num_ballots,
+    char *const *external_identifiers, bool const *const *selections,
+    uint32_t const *expected_num_selected, uint32_t num_threads,
+    struct Voting_Encrypter_encrypt_ballot_r *out_results)
+{
+    enum Voting_Encrypter_status status = VOTING_ENCRYPTER_SUCCESS;
+
+    struct Voting_Encrypter_pool pool = {
+        .encrypter = encrypter,
+        .jobs = malloc(num_ballots * sizeof(struct Voting_Encrypter_ballot_job)),
+        .num_ballots = num_ballots,
+        .chunks_per_ballot =
+            (encrypter->num_selections + VOTING_ENCRYPTER_SELECTION_CHUNK - 1) /
+            VOTING_ENCRYPTER_SELECTION_CHUNK,
+        .phase = VOTING_ENCRYPTER_ENCRYPTING,
+    };
+    atomic_init(&pool.next, 0);
+
+    if (pool.jobs == NULL)
+        status = VOTING_ENCRYPTER_INSUFFICIENT_MEMORY;
+
+    // Without room for the threads, do all the work on this one
+    pthread_t *threads = NULL;
+    if (num_threads > 1)
+        threads = malloc((num_threads - 1) * sizeof(pthread_t));
+    if (threads == NULL)
+        num_threads = 1;
+
+    if (status == VOTING_ENCRYPTER_SUCCESS)
+    {
+        // Ids are handed out in the order the ballots were given
+        for (uint32_t i = 0; i < num_ballots; i++)
+        {
+            pool.jobs[i] = (struct Voting_Encrypter_ballot_job){
+                .external_identifier = external_identifiers[i],
+                .selections = selections[i],
+                .expected_num_selected = expected_num_selected[i],
+            };
+            Voting_Encrypter_ballot_job_begin(encrypter, &pool.jobs[i]);
+        }
+
+        Voting_Encrypter_pool_fan_out(&pool, threads, num_threads);
+        pool.phase = VOTING_ENCRYPTER_FINISHING;
+        Voting_Encrypter_pool_fan_out(&pool, threads, num_threads);
+        pool.phase = VOTING_ENCRYPTER_TRACKING;
+        Voting_Encrypter_pool_fan_out(&pool, threads, num_threads);
+
+        for (uint32_t i = 0; i < num_ballots; i++)
+        {
+            out_results[i] = pool.jobs[i].result;
+            if (status == VOTING_ENCRYPTER_SUCCESS)
+                status = out_results[i].status;
+        }
+    }
+
+    free(threads);
+    free(pool.jobs);
+
+    return status;
 }
 
 enum Voting_Encrypter_status
@@ -447,3 +1255,83 @@ Voting_Encrypter_write_ballot(FILE *out, char *external_identifier,
 
     return status;
 }
+
+enum Voting_Encrypter_status
+Voting_Encrypter_write_ballot_binary(FILE *out, char *external_identifier,
+                                     struct register_ballot_message *encrypted_ballot_message)
+{
+    enum Voting_Encrypter_status status = VOTING_ENCRYPTER_SUCCESS;
+
+    struct encrypted_ballot_rep message_rep = {.num_selections = 0,
+                                               .selections = NULL};
+
+    // Deserialize the message
+    {
+        struct serialize_state state = {
+            .status = SERIALIZE_STATE_READING,
+            .len = encrypted_ballot_message->len,
+            .offset = 0,
+            .buf = (uint8_t *)encrypted_ballot_message->bytes,
+        };
+
+        Serialize_read_encrypted_ballot(&state, &message_rep);
+
+        if (state.status != SERIALIZE_STATE_READING)
+        {
+            status = VOTING_ENCRYPTER_DESERIALIZE_ERROR;
+        }
+    }
+
+    // Start a new file, or add to the ballots already in this one
+    struct ballot_record_header header = {
+        .num_selections = message_rep.num_selections,
+        .external_id_width = BALLOT_RECORD_EXTERNAL_ID_WIDTH,
+        .num_records = 0,
+    };
+
+    if (status == VOTING_ENCRYPTER_SUCCESS)
+    {
+        if (fseek(out, 0L, SEEK_END) != 0)
+            status = VOTING_ENCRYPTER_IO_ERROR;
+        else if (ftell(out) > 0)
+        {
+            struct ballot_record_header existing;
+            if (fseek(out, 0L, SEEK_SET) != 0 ||
+                Ballot_Record_read_header(out, &existing) != BALLOT_RECORD_SUCCESS ||
+                existing.num_selections != message_rep.num_selections)
+                status = VOTING_ENCRYPTER_IO_ERROR;
+            else
+                header = existing;
+        }
+    }
+
+    // Write the ballot after the existing ones, then the new count
+    if (status == VOTING_ENCRYPTER_SUCCESS)
+    {
+        long end = BALLOT_RECORD_HEADER_SIZE +
+                   (long)(header.num_records * Ballot_Record_record_size(&header));
+        if (fseek(out, end, SEEK_SET) != 0 ||
+            Ballot_Record_write(out, &header, message_rep.id, false,
+                                external_identifier, message_rep.selections) !=
+                BALLOT_RECORD_SUCCESS)
+            status = VOTING_ENCRYPTER_IO_ERROR;
+    }
+
+    if (status == VOTING_ENCRYPTER_SUCCESS)
+    {
+        header.num_records++;
+        if (fseek(out, 0L, SEEK_SET) != 0 ||
+            Ballot_Record_write_header(out, &header) != BALLOT_RECORD_SUCCESS ||
+            fflush(out) != 0)
+            status = VOTING_ENCRYPTER_IO_ERROR;
+    }
+
+    // free the ballot rep
+    for (uint32_t i = 0; i < message_rep.num_selections && message_rep.selections != NULL; i++)
+    {
+        Crypto_encryption_rep_free(&message_rep.selections[i]);
+    }
+    free(message_rep.selections);
+
+    return status;
+}
@@ -0,0 +1,638 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <electionguard/api/create_election.h>
+#include <electionguard/api/encrypt_ballot.h>
+#include <electionguard/api/load_ballots.h>
+#include <electionguard/api/tally_votes.h>
+#include <electionguard/decryption/coordinator.h>
+#include <electionguard/max_values.h>
+#include <electionguard/voting/coordinator.h>
+#include <electionguard/voting/encrypter.h>
+
+/* Runs a small election through the public API and records its ballots
+ * twice, once as a text voting record and once as a binary one, then
+ * checks that both tally to the expected counts. Along the way it checks
+ * that a binary ballot file imports to the ballots written to it, that the
+ * voting coordinator refuses ballots past its limit, that a saved discrete
+ * log table reads back whole and is refused when cut short, that
+ * auditing a proofs file passes it whole and catches a forged response,
+ * and that ballots load the same through a ballot file's index whether or
+ * not it is corrupt. */
+
+#define NUM_TRUSTEES 3
+#define THRESHOLD 2
+#define NUM_SELECTIONS 3
+#define NUM_BALLOTS 12
+
+// One ballot in this many is spoiled
+#define SPOIL_RATE 4
+
+static bool is_spoiled(uint32_t i) { return i % SPOIL_RATE == SPOIL_RATE - 1; }
+
+static bool check(bool ok, const char *what)
+{
+    if (!ok)
+        fprintf(stderr, "record_formats: %s\n", what);
+    return ok;
+}
+
+/* Check that the ballots in a binary ballot file import as the ones
+ * written to it */
+static bool import_ballot_file(FILE *in, char **external_identifiers,
+                               struct register_ballot_message *ballots)
+{
+    bool ok = true;
+    char *identifiers[NUM_BALLOTS] = {NULL};
+    struct register_ballot_message imported[NUM_BALLOTS];
+    memset(imported, 0, sizeof(imported));
+
+    struct Voting_Coordinator_new_r result =
+        Voting_Coordinator_new(NUM_SELECTIONS);
+    ok = check(result.status == VOTING_COORDINATOR_SUCCESS,
+               "Voting_Coordinator_new failed");
+
+    if (ok)
+        ok = check(Voting_Coordinator_import_encrypted_ballots(
+                       result.coordinator, 0, NUM_BALLOTS, NUM_SELECTIONS, in,
+                       identifiers, imported) == VOTING_COORDINATOR_SUCCESS,
+                   "importing the binary ballot file failed");
+
+    for (uint32_t i = 0; i < NUM_BALLOTS && ok; i++)
+        ok = check(identifiers[i] != NULL &&
+                       strcmp(identifiers[i], external_identifiers[i]) == 0 &&
+                       imported[i].len == ballots[i].len &&
+                       memcmp(imported[i].bytes, ballots[i].bytes,
+                              ballots[i].len) == 0,
+                   "an imported ballot differs from the one written");
+
+    for (uint32_t i = 0; i < NUM_BALLOTS; i++)
+    {
+        free(identifiers[i]);
+        if (imported[i].bytes != NULL)
+            API_EncryptBallot_free(imported[i], NULL);
+    }
+
+    if (result.coordinator != NULL)
+        Voting_Coordinator_free(result.coordinator);
+
+    return ok;
+}
+
+/* Register, cast and spoil the ballots, and export them to out as a text
+ * or a binary voting record */
+static bool record_ballots(FILE *out, bool binary, char **external_identifiers,
+                           struct register_ballot_message *ballots)
+{
+    bool ok = true;
+    char *trackers[NUM_BALLOTS] = {NULL};
+
+    struct Voting_Coordinator_new_r result =
+        Voting_Coordinator_new(NUM_SELECTIONS);
+    ok = check(result.status == VOTING_COORDINATOR_SUCCESS,
+               "Voting_Coordinator_new failed");
+
+    if (ok)
+        Voting_Coordinator_set_max_ballots(result.coordinator, NUM_BALLOTS);
+
+    for (uint32_t i = 0; i < NUM_BALLOTS && ok; i++)
+    {
+        char *tracker;
+        ok = check(Voting_Coordinator_register_ballot(
+                       result.coordinator, external_identifiers[i],
+                       ballots[i], &tracker) == VOTING_COORDINATOR_SUCCESS,
+                   "registering a ballot failed");
+    }
+
+    if (ok)
+    {
+        char *tracker = NULL;
+        ok = check(Voting_Coordinator_register_ballot(
+                       result.coordinator, "one-too-many", ballots[0],
+                       &tracker) == VOTING_COORDINATOR_INVALID_BALLOT_INDEX,
+                   "a ballot past the limit was registered");
+    }
+
+    for (uint32_t i = 0; i < NUM_BALLOTS && ok; i++)
+    {
+        enum Voting_Coordinator_status status =
+            is_spoiled(i)
+                ? Voting_Coordinator_spoil_ballot(
+                      result.coordinator, external_identifiers[i], &trackers[i])
+                : Voting_Coordinator_cast_ballot(
+                      result.coordinator, external_identifiers[i], &trackers[i]);
+        ok = check(status == VOTING_COORDINATOR_SUCCESS,
+                   "casting or spoiling a ballot failed");
+    }
+
+    if (ok)
+    {
+        enum Voting_Coordinator_status status =
+            binary ? Voting_Coordinator_export_buffered_ballots_binary(
+                         result.coordinator, out)
+                   : Voting_Coordinator_export_buffered_ballots(
+                         result.coordinator, out);
+        ok = check(status == VOTING_COORDINATOR_SUCCESS,
+                   "exporting the ballots failed");
+    }
+
+    // The coordinator hands out the tracker made at registration when the
+    // ballot is cast or spoiled, and leaves freeing it to the caller
+    for (uint32_t i = 0; i < NUM_BALLOTS; i++)
+        free(trackers[i]);
+
+    if (result.coordinator != NULL)
+        Voting_Coordinator_free(result.coordinator);
+
+    return ok;
+}
+
+// The first ballot loaded through the index
+#define LOAD_START 5
+
+/* Check that the ballots from LOAD_START on load from the exported ballot
+ * file as the ones encrypted */
+static bool load_ballots(char *ballots_filename, char **external_identifiers,
+                         struct register_ballot_message *ballots)
+{
+    bool ok = true;
+    const uint32_t count = NUM_BALLOTS - LOAD_START;
+    char *identifiers[NUM_BALLOTS - LOAD_START] = {NULL};
+    struct register_ballot_message loaded[NUM_BALLOTS - LOAD_START];
+    memset(loaded, 0, sizeof(loaded));
+
+    ok = check(API_LoadBallots(LOAD_START, count, NUM_SELECTIONS,
+                               ballots_filename, identifiers, loaded) ==
+                   API_LOADBALLOTS_SUCCESS,
+               "API_LoadBallots failed");
+
+    for (uint32_t i = 0; i < count && ok; i++)
+        ok = check(identifiers[i] != NULL &&
+                       strcmp(identifiers[i],
+                              external_identifiers[LOAD_START + i]) == 0 &&
+                       loaded[i].len == ballots[LOAD_START + i].len &&
+                       memcmp(loaded[i].bytes, ballots[LOAD_START + i].bytes,
+                              loaded[i].len) == 0,
+                   "a loaded ballot differs from the one encrypted");
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        free(identifiers[i]);
+        if (loaded[i].bytes != NULL)
+            API_EncryptBallot_free(loaded[i], NULL);
+    }
+    API_LoadBallots_free(NULL);
+
+    return ok;
+}
+
+/* Check that ballots load through the index kept beside the ballot file,
+ * and still load when the index points a byte past a ballot's line */
+static bool check_indexed_load(char *ballots_filename,
+                               char **external_identifiers,
+                               struct register_ballot_message *ballots)
+{
+    bool ok = load_ballots(ballots_filename, external_identifiers, ballots);
+
+    // The index is a 16 byte header then a little endian offset per ballot
+    char index_filename[FILENAME_MAX];
+    snprintf(index_filename, FILENAME_MAX, "%s.index", ballots_filename);
+    FILE *index = NULL;
+    if (ok)
+    {
+        index = fopen(index_filename, "r+b");
+        ok = check(index != NULL, "the ballot file has no index");
+    }
+
+    uint8_t offset[8];
+    if (ok)
+        ok = check(fseek(index, 16 + 8 * LOAD_START, SEEK_SET) == 0 &&
+                       fread(offset, 1, sizeof offset, index) == sizeof offset,
+                   "the index is too short");
+
+    // Add one to the offset
+    for (uint32_t i = 0; i < sizeof offset && ok; i++)
+        if (++offset[i] != 0)
+            break;
+
+    if (ok)
+        ok = check(fseek(index, 16 + 8 * LOAD_START, SEEK_SET) == 0 &&
+                       fwrite(offset, 1, sizeof offset, index) == sizeof offset,
+                   "corrupting the index failed");
+
+    if (index != NULL)
+        fclose(index);
+
+    if (ok)
+        ok = load_ballots(ballots_filename, external_identifiers, ballots);
+
+    return ok;
+}
+
+/* Check that exporting no ballots to a copy of a text voting record with
+ * the variable-width count of older releases gives back the record, the
+ * count now fixed-width. legacy must be empty. */
+static bool check_legacy_header(FILE *record, FILE *legacy)
+{
+    bool ok = true;
+
+    uint32_t count = 0;
+    rewind(record);
+    ok = check(fscanf(record, "%" SCNu32, &count) == 1,
+               "the text record has no count");
+
+    int c;
+    if (ok)
+        ok = fprintf(legacy, "%" PRIu32, count) > 0;
+    while (ok && (c = fgetc(record)) != EOF)
+        ok = fputc(c, legacy) != EOF;
+
+    struct Voting_Coordinator_new_r result =
+        Voting_Coordinator_new(NUM_SELECTIONS);
+    if (ok)
+        ok = check(result.status == VOTING_COORDINATOR_SUCCESS,
+                   "Voting_Coordinator_new failed");
+    if (ok)
+        ok = check(Voting_Coordinator_export_buffered_ballots(
+                       result.coordinator, legacy) ==
+                       VOTING_COORDINATOR_SUCCESS,
+                   "exporting to a record with an old header failed");
+    if (result.coordinator != NULL)
+        Voting_Coordinator_free(result.coordinator);
+
+    if (ok)
+    {
+        rewind(record);
+        rewind(legacy);
+        int expected;
+        do
+        {
+            expected = fgetc(record);
+            ok = check(fgetc(legacy) == expected,
+                       "a record with an old header was migrated wrongly");
+        } while (ok && expected != EOF);
+    }
+
+    return ok;
+}
+
+/* Check that the default discrete log table written by one decryption
+ * coordinator to table is read whole by another, and refused when cut
+ * short. copy and truncated must be empty. */
+static bool check_dlog_table(FILE *table, FILE *copy, FILE *truncated)
+{
+    bool ok = true;
+
+    struct Decryption_Coordinator_new_r writer =
+        Decryption_Coordinator_new(NUM_TRUSTEES, THRESHOLD);
+    struct Decryption_Coordinator_new_r reader =
+        Decryption_Coordinator_new(NUM_TRUSTEES, THRESHOLD);
+    ok = check(writer.status == DECRYPTION_COORDINATOR_SUCCESS &&
+                   reader.status == DECRYPTION_COORDINATOR_SUCCESS,
+               "Decryption_Coordinator_new failed");
+
+    if (ok)
+        ok = check(Decryption_Coordinator_write_dlog_table(
+                       writer.coordinator, table) ==
+                       DECRYPTION_COORDINATOR_SUCCESS,
+                   "writing the discrete log table failed");
+
+    if (ok)
+    {
+        rewind(table);
+        ok = check(Decryption_Coordinator_read_dlog_table(
+                       reader.coordinator, table) ==
+                           DECRYPTION_COORDINATOR_SUCCESS &&
+                       Decryption_Coordinator_write_dlog_table(
+                           reader.coordinator, copy) ==
+                           DECRYPTION_COORDINATOR_SUCCESS,
+                   "reading the discrete log table back failed");
+    }
+
+    // The table read back is written out byte for byte the same
+    long size = 0;
+    if (ok)
+    {
+        fseek(table, 0, SEEK_END);
+        size = ftell(table);
+        ok = check(size > 0 && ftell(copy) == size,
+                   "the discrete log table read back has a different size");
+        rewind(table);
+        rewind(copy);
+    }
+
+    for (long i = 0; i < size && ok; i++)
+        ok = check(fgetc(table) == fgetc(copy),
+                   "the discrete log table read back differs");
+
+    // Keep only the first half of the table
+    if (ok)
+    {
+        rewind(table);
+        for (long i = 0; i < size / 2; i++)
+            fputc(fgetc(table), truncated);
+        rewind(truncated);
+
+        ok = check(Decryption_Coordinator_read_dlog_table(
+                       reader.coordinator, truncated) ==
+                       DECRYPTION_COORDINATOR_IO_ERROR,
+                   "a truncated discrete log table was read");
+    }
+
+    if (writer.coordinator != NULL)
+        Decryption_Coordinator_free(writer.coordinator);
+    if (reader.coordinator != NULL)
+        Decryption_Coordinator_free(reader.coordinator);
+
+    return ok;
+}
+
+// Number of ballots whose proofs are written to the audited file
+#define NUM_AUDITED 4
+
+static bool audit_proofs(Voting_Encrypter encrypter, FILE *in,
+                         uint64_t expected_num_invalid)
+{
+    uint64_t num_ballots = 0, num_invalid = 0;
+    rewind(in);
+    return check(Voting_Encrypter_audit_proofs(encrypter, in, &num_ballots,
+                                               &num_invalid) ==
+                         VOTING_ENCRYPTER_SUCCESS &&
+                     num_ballots == NUM_AUDITED &&
+                     num_invalid == expected_num_invalid,
+                 "Voting_Encrypter_audit_proofs counted wrongly");
+}
+
+static bool check_proofs_audit(struct joint_public_key joint_key,
+                               FILE *proofs, FILE *forged)
+{
+    uint8_t id_buf[1] = {0};
+    struct uid uid = {.len = 1, .bytes = id_buf};
+    raw_hash base_hash = {1};
+
+    struct Voting_Encrypter_new_r encrypter =
+        Voting_Encrypter_new(uid, joint_key, NUM_SELECTIONS, base_hash);
+    bool ok = check(encrypter.status == VOTING_ENCRYPTER_SUCCESS,
+                    "Voting_Encrypter_new failed");
+    if (ok)
+        Voting_Encrypter_set_proofs_file(encrypter.encrypter, proofs);
+
+    for (uint32_t i = 0; i < NUM_AUDITED && ok; i++)
+    {
+        char external_identifier[] = "audited";
+        bool selections[NUM_SELECTIONS] = {false};
+        selections[i % NUM_SELECTIONS] = true;
+
+        struct Voting_Encrypter_encrypt_ballot_r result =
+            Voting_Encrypter_encrypt_ballot(encrypter.encrypter,
+                                            external_identifier, selections, 1);
+        ok = check(result.status == VOTING_ENCRYPTER_SUCCESS,
+                   "Voting_Encrypter_encrypt_ballot failed");
+        free((void *)result.message.bytes);
+        free((void *)result.tracker.bytes);
+        free((void *)result.id.bytes);
+    }
+
+    if (ok)
+        ok = audit_proofs(encrypter.encrypter, proofs, 0);
+
+    // Copy the file with the last digit of the first proof's last response
+    // changed, which leaves every element in the group
+    if (ok)
+    {
+        int c, tuples = 0;
+        bool forging = true;
+        rewind(proofs);
+        while ((c = fgetc(proofs)) != EOF && ok)
+        {
+            if (c == '(')
+                tuples++;
+            if (forging && tuples == 2 && c == ')')
+            {
+                fseek(forged, -1, SEEK_CUR);
+                int last = fgetc(forged);
+                fseek(forged, -1, SEEK_CUR);
+                fputc(last == '0' ? '1' : '0', forged);
+                forging = false;
+            }
+            ok = fputc(c, forged) != EOF;
+        }
+    }
+    if (ok)
+        ok = audit_proofs(encrypter.encrypter, forged, 1);
+
+    if (encrypter.status == VOTING_ENCRYPTER_SUCCESS)
+        Voting_Encrypter_free(encrypter.encrypter);
+
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    bool ok = true;
+    const char *work_path = argc > 1 ? argv[1] : "record_formats_work";
+
+    char export_path[FILENAME_MAX];
+    char ballots_path[FILENAME_MAX];
+    char text_path[FILENAME_MAX];
+    char binary_path[FILENAME_MAX];
+    char tally_path[FILENAME_MAX];
+    snprintf(export_path, FILENAME_MAX, "%s/", work_path);
+    snprintf(ballots_path, FILENAME_MAX, "%s/ballots.bin", work_path);
+    snprintf(text_path, FILENAME_MAX, "%s/record.txt", work_path);
+    snprintf(binary_path, FILENAME_MAX, "%s/record.bin", work_path);
+    snprintf(tally_path, FILENAME_MAX, "%s/tallies/", work_path);
+
+    char *external_identifiers[NUM_BALLOTS] = {NULL};
+    char *trackers[NUM_BALLOTS] = {NULL};
+    struct register_ballot_message ballots[NUM_BALLOTS];
+    memset(ballots, 0, sizeof(ballots));
+    uint32_t expected_tally[NUM_SELECTIONS] = {0};
+    uint32_t text_tally[NUM_SELECTIONS] = {0};
+    uint32_t binary_tally[NUM_SELECTIONS] = {0};
+
+    // Create Election
+
+    struct api_config config = {
+        .num_selections = NUM_SELECTIONS,
+        .num_trustees = NUM_TRUSTEES,
+        .threshold = THRESHOLD,
+        .subgroup_order = 0,
+        .election_meta = "record_formats",
+        .joint_key = {.bytes = NULL},
+    };
+    struct trustee_state trustee_states[MAX_TRUSTEES];
+
+    bool created = ok =
+        check(API_CreateElection(&config, trustee_states),
+              "API_CreateElection failed");
+
+    // Encrypt Ballots, ballot i choosing option i mod NUM_SELECTIONS
+
+    uint32_t num_encrypted = 0;
+    char *ballots_filename = NULL;
+    if (ok)
+        ok = check(API_EncryptBallot_soft_delete_file(export_path, "ballots"),
+                   "API_EncryptBallot_soft_delete_file failed");
+
+    for (uint32_t i = 0; i < NUM_BALLOTS && ok; i++)
+    {
+        external_identifiers[i] = malloc(MAX_EXTERNAL_ID_LENGTH);
+        ok = check(external_identifiers[i] != NULL, "out of memory");
+        if (!ok)
+            break;
+        snprintf(external_identifiers[i], MAX_EXTERNAL_ID_LENGTH,
+                 "ballot-%" PRIu32, i);
+
+        uint8_t selections[NUM_SELECTIONS] = {0};
+        selections[i % NUM_SELECTIONS] = 1;
+        if (!is_spoiled(i))
+            expected_tally[i % NUM_SELECTIONS]++;
+
+        char *filename = NULL;
+        ok = check(API_EncryptBallot(selections, 1, config,
+                                     external_identifiers[i], &ballots[i],
+                                     export_path, "ballots", &filename,
+                                     &trackers[i]),
+                   "API_EncryptBallot failed");
+        if (ok)
+            num_encrypted++;
+        if (ballots_filename == NULL)
+            ballots_filename = filename;
+        else
+            free(filename);
+    }
+
+    // Record the ballots both ways. The SDK calls between here and the
+    // tallies are below the API, so they need the group parameters set.
+
+    FILE *ballot_file = NULL, *text_record = NULL, *binary_record = NULL;
+    FILE *legacy_record = NULL;
+    FILE *table = NULL, *table_copy = NULL, *table_truncated = NULL;
+    FILE *proofs = NULL, *forged = NULL;
+    if (ok)
+    {
+        ballot_file = fopen(ballots_path, "w+b");
+        text_record = fopen(text_path, "w+");
+        binary_record = fopen(binary_path, "w+b");
+        legacy_record = tmpfile();
+        table = tmpfile();
+        table_copy = tmpfile();
+        table_truncated = tmpfile();
+        proofs = tmpfile();
+        forged = tmpfile();
+        ok = check(ballot_file != NULL && text_record != NULL &&
+                       binary_record != NULL && legacy_record != NULL &&
+                       table != NULL &&
+                       table_copy != NULL && table_truncated != NULL &&
+                       proofs != NULL && forged != NULL,
+                   "opening the work files failed");
+    }
+
+    if (ok)
+    {
+        Crypto_parameters_new();
+
+        for (uint32_t i = 0; i < NUM_BALLOTS && ok; i++)
+            ok = check(Voting_Encrypter_write_ballot_binary(
+                           ballot_file, external_identifiers[i],
+                           &ballots[i]) == VOTING_ENCRYPTER_SUCCESS,
+                       "Voting_Encrypter_write_ballot_binary failed");
+
+        if (ok)
+        {
+            rewind(ballot_file);
+            ok = import_ballot_file(ballot_file, external_identifiers, ballots);
+        }
+
+        if (ok)
+            ok = record_ballots(text_record, false, external_identifiers,
+                                ballots);
+        if (ok)
+            ok = record_ballots(binary_record, true, external_identifiers,
+                                ballots);
+        if (ok)
+            ok = check_legacy_header(text_record, legacy_record);
+        if (ok)
+            ok = check_dlog_table(table, table_copy, table_truncated);
+        if (ok)
+            ok = check_proofs_audit(config.joint_key, proofs, forged);
+
+        Crypto_parameters_free();
+    }
+
+    if (ballot_file != NULL)
+        fclose(ballot_file);
+    if (text_record != NULL)
+        fclose(text_record);
+    if (binary_record != NULL)
+        fclose(binary_record);
+    if (legacy_record != NULL)
+        fclose(legacy_record);
+    if (table != NULL)
+        fclose(table);
+    if (table_copy != NULL)
+        fclose(table_copy);
+    if (table_truncated != NULL)
+        fclose(table_truncated);
+    if (proofs != NULL)
+        fclose(proofs);
+    if (forged != NULL)
+        fclose(forged);
+
+    if (ok)
+        ok = check_indexed_load(ballots_filename, external_identifiers,
+                                ballots);
+
+    // Tally Votes, with just enough trustees that the missing one's share
+    // is made up from fragments
+
+    char *text_tally_filename = NULL;
+    char *binary_tally_filename = NULL;
+
+    if (ok)
+        ok = check(API_TallyVotes(config, trustee_states, THRESHOLD, text_path,
+                                  tally_path, "text", &text_tally_filename,
+                                  text_tally),
+                   "API_TallyVotes failed on the text record");
+    if (ok)
+        ok = check(API_TallyVotes(config, trustee_states, THRESHOLD,
+                                  binary_path, tally_path, "binary",
+                                  &binary_tally_filename, binary_tally),
+                   "API_TallyVotes failed on the binary record");
+
+    for (uint32_t i = 0; i < NUM_SELECTIONS && ok; i++)
+    {
+        if (text_tally[i] != expected_tally[i] ||
+            binary_tally[i] != expected_tally[i])
+        {
+            fprintf(stderr,
+                    "record_formats: selection %" PRIu32 ": expected %" PRIu32
+                    ", tallied %" PRIu32 " from text and %" PRIu32
+                    " from binary\n",
+                    i, expected_tally[i], text_tally[i], binary_tally[i]);
+            ok = false;
+        }
+    }
+
+    // Clean up
+
+    free(ballots_filename);
+    API_TallyVotes_free(text_tally_filename);
+    API_TallyVotes_free(binary_tally_filename);
+
+    for (uint32_t i = 0; i < num_encrypted; i++)
+        API_EncryptBallot_free(ballots[i], trackers[i]);
+    for (uint32_t i = 0; i < NUM_BALLOTS; i++)
+        free(external_identifiers[i]);
+
+    if (created)
+        API_CreateElection_free(config.joint_key, trustee_states);
+
+    printf("record_formats: %s\n", ok ? "passed" : "FAILED");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}